@@ -0,0 +1,130 @@
+/* [OFF READER BENCHMARK]
+* MB/s of Mesh::read (memory map, parallel chunks) against the std::ifstream
+* reader it replaced, on data/bunny.off and on synthetic grids written to
+* the working directory. Both readers must produce the same mesh.
+*
+* usage: off_reader_bench [file.off ...]   (default: data/bunny.off)
+*/
+#include "lib/features/MeshClass.h"
+
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace SceneEditor;
+
+namespace {
+
+	// The reader Mesh::read replaced, kept as the baseline
+	void readIfstream(const std::string& path, std::vector<glm::vec3>& vertices, std::vector<int>& indices) {
+		std::ifstream infile(path, std::ifstream::binary);
+
+		std::string line;
+		std::getline(infile, line);
+
+		int n_vertex, n_face, n_edge, tmp;
+		infile >> n_vertex >> n_face >> n_edge;
+		vertices.assign(n_vertex, glm::vec3(0.f));
+		indices.assign(n_face * 3, 0);
+		for (int i = 0; i < n_vertex; ++i) {
+			infile >> vertices[i][0] >> vertices[i][1] >> vertices[i][2];
+		}
+		for (int i = 0; i < n_face; ++i) {
+			infile >> tmp;
+			for (int j = 0; j < 3; ++j) {
+				infile >> indices[3 * i + j];
+			}
+		}
+	}
+
+	// side x side grid with jittered heights, two triangles per cell
+	std::string writeGrid(int side) {
+		std::string path = "off_reader_bench_" + std::to_string(side) + ".off";
+		FILE* file = std::fopen(path.c_str(), "wb");
+		if (!file) { return std::string(); }
+		std::mt19937 rng(side);
+		std::uniform_real_distribution<float> height(-1.f, 1.f);
+		int n_faces = 2 * (side - 1) * (side - 1);
+		std::fprintf(file, "OFF\n%d %d 0\n", side * side, n_faces);
+		for (int y = 0; y < side; ++y) {
+			for (int x = 0; x < side; ++x) {
+				std::fprintf(file, "%.6f %.6f %.6f\n", x / float(side), height(rng), y / float(side));
+			}
+		}
+		for (int y = 0; y + 1 < side; ++y) {
+			for (int x = 0; x + 1 < side; ++x) {
+				int v = y * side + x;
+				std::fprintf(file, "3 %d %d %d\n3 %d %d %d\n", v, v + side, v + 1, v + 1, v + side, v + side + 1);
+			}
+		}
+		std::fclose(file);
+		return path;
+	}
+
+	size_t fileSize(const std::string& path) {
+		std::ifstream file(path, std::ifstream::binary | std::ifstream::ate);
+		return file ? (size_t)file.tellg() : 0;
+	}
+
+	// best of a few runs, in ms
+	template<typename Reader>
+	double timeReader(Reader reader, const std::string& path, std::vector<glm::vec3>& vertices, std::vector<int>& indices) {
+		double best = 1e30;
+		for (int run = 0; run < 3; ++run) {
+			auto t_start = std::chrono::high_resolution_clock::now();
+			reader(path, vertices, indices);
+			auto t_end = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(t_end - t_start).count());
+		}
+		return best;
+	}
+
+	bool bench(const std::string& path) {
+		size_t bytes = fileSize(path);
+		if (bytes == 0) {
+			std::printf("[BENCHMARK::OFF READER] %s || CANNOT READ\n", path.c_str());
+			return false;
+		}
+		std::vector<glm::vec3> old_vertices, new_vertices;
+		std::vector<int> old_indices, new_indices;
+		double old_ms = timeReader(readIfstream, path, old_vertices, old_indices);
+		double new_ms = timeReader([](const std::string& p, std::vector<glm::vec3>& v, std::vector<int>& i) { Mesh::read(p, v, i); },
+			path, new_vertices, new_indices);
+		bool same = old_vertices == new_vertices && old_indices == new_indices;
+		double mb = bytes / (1024.0 * 1024.0);
+		std::printf("[BENCHMARK::OFF READER] %s || %.3f MB, %zu VERTICES, %zu TRIANGLES\n",
+			path.c_str(), mb, new_vertices.size(), new_indices.size() / 3);
+		std::printf("[BENCHMARK::OFF READER]   ifstream  %9.3f ms  %8.1f MB/s\n", old_ms, mb / (old_ms / 1000.0));
+		std::printf("[BENCHMARK::OFF READER]   Mesh::read %8.3f ms  %8.1f MB/s  (x%.1f)%s\n", new_ms, mb / (new_ms / 1000.0),
+			old_ms / new_ms, same ? "" : "  MISMATCH");
+		return same;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; ++i) {
+		files.push_back(argv[i]);
+	}
+	if (files.empty()) {
+		files.push_back("data/bunny.off");
+	}
+	bool ok = true;
+	for (auto&& path : files) {
+		ok = bench(path) && ok;
+	}
+	const int sides[] = { 256, 1024, 2048 };
+	for (int side : sides) {
+		std::string path = writeGrid(side);
+		if (path.empty()) { continue; }
+		ok = bench(path) && ok;
+		std::remove(path.c_str());
+	}
+	return ok ? 0 : 1;
+}
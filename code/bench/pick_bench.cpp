@@ -0,0 +1,101 @@
+/* [PICK BENCHMARK]
+* Pick latency against triangle count: builds the per-mesh Bvh for bumpy
+* spheres of increasing size and times Bvh::intersect for click-like rays
+* (from a camera distance towards a point inside the mesh's bounds).
+*
+* usage: pick_bench [n_rays]   (default: 10000 rays per mesh)
+*/
+#include "lib/features/BvhClass.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace SceneEditor;
+
+namespace {
+
+	// (rings x 2 * rings) sphere with a jittered radius, about 4 * rings^2 triangles
+	void makeSphere(int rings, std::vector<glm::vec3>& vertices, std::vector<int>& indices) {
+		const float pi = 3.14159265f;
+		int segments = 2 * rings;
+		std::mt19937 rng(rings);
+		std::uniform_real_distribution<float> bump(0.97f, 1.03f);
+		vertices.clear();
+		indices.clear();
+		for (int r = 0; r <= rings; ++r) {
+			float theta = pi * r / rings;
+			for (int s = 0; s < segments; ++s) {
+				float phi = 2.f * pi * s / segments;
+				float radius = bump(rng);
+				vertices.push_back(radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+			}
+		}
+		for (int r = 0; r < rings; ++r) {
+			for (int s = 0; s < segments; ++s) {
+				int a = r * segments + s;
+				int b = r * segments + (s + 1) % segments;
+				int c = a + segments;
+				int d = b + segments;
+				if (r > 0) {
+					indices.push_back(a); indices.push_back(b); indices.push_back(c);
+				}
+				if (r + 1 < rings) {
+					indices.push_back(b); indices.push_back(d); indices.push_back(c);
+				}
+			}
+		}
+	}
+
+	double elapsedUs(std::chrono::high_resolution_clock::time_point t_start) {
+		return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - t_start).count();
+	}
+
+	void bench(int rings, int n_rays) {
+		std::vector<glm::vec3> vertices;
+		std::vector<int> indices;
+		makeSphere(rings, vertices, indices);
+
+		Bvh bvh;
+		auto t_build = std::chrono::high_resolution_clock::now();
+		bvh.build(vertices, indices);
+		double build_ms = elapsedUs(t_build) / 1000.0;
+
+		std::mt19937 rng(n_rays);
+		std::uniform_real_distribution<float> unit(-1.f, 1.f);
+		std::vector<double> latency(n_rays);
+		size_t hits = 0;
+		for (int i = 0; i < n_rays; ++i) {
+			glm::vec3 dir;
+			do { dir = glm::vec3(unit(rng), unit(rng), unit(rng)); } while (glm::dot(dir, dir) < 1e-4f);
+			glm::vec3 e = 4.f * glm::normalize(dir);
+			glm::vec3 target(unit(rng), unit(rng), unit(rng));
+			glm::vec3 d = glm::normalize(target - e);
+			auto t_start = std::chrono::high_resolution_clock::now();
+			auto p = bvh.intersect(e, d, 0.f, 100.f);
+			latency[i] = elapsedUs(t_start);
+			hits += p.first;
+		}
+		std::sort(latency.begin(), latency.end());
+		double sum = 0.0;
+		for (double us : latency) { sum += us; }
+		std::printf("[BENCHMARK::PICKING] %9zu TRIANGLES || BUILD %9.2f ms, %7zu NODES || PICK MEAN %7.2f us, P50 %7.2f us, P99 %7.2f us || %zu/%d HITS\n",
+			indices.size() / 3, build_ms, bvh.nodes().size(), sum / n_rays, latency[n_rays / 2], latency[n_rays * 99 / 100], hits, n_rays);
+	}
+}
+
+int main(int argc, char** argv) {
+	int n_rays = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10000;
+	std::printf("[BENCHMARK::PICKING] RAY KERNEL: %s\n", RayKernel::isa());
+	const int rings[] = { 16, 32, 64, 128, 256, 512, 1024 };
+	for (int r : rings) {
+		bench(r, n_rays);
+	}
+	return 0;
+}
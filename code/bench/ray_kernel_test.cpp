@@ -0,0 +1,279 @@
+/* [RAY KERNEL TEST]
+* Random rays against random triangle packets through every RayKernel
+* implementation this build and CPU support (scalar, SSE, AVX2), plus the
+* dispatched kernel behind Bvh::intersect. Every hit and every t is checked
+* against Object::intersectTriangle; any mismatch fails the run. Both sides
+* compute in float, so t may differ by the rounding error of a ray/triangle
+* pair, which is estimated from its conditioning in double precision. Rays
+* that graze an edge or run parallel to a triangle are skipped, since
+* rounding may legitimately go either way there. Prints triangles/sec per
+* kernel at the end.
+*
+* usage: ray_kernel_test [n_rays]   (default: 200000)
+*/
+#include "lib/features/BvhClass.h"
+#include "lib/features/RayKernelClass.h"
+#include "lib/geometry/GeometryClass.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace SceneEditor;
+
+namespace {
+
+	const int W = TrianglePacket::s_width;
+	const float s_near = 0.f;
+	const float s_far = 100.f;
+	const double s_margin = 1e-4;  // smallest barycentric / relative distance counted as clear of an edge
+	const double s_ulps = 8.0;     // rounding error allowed, in float epsilons times the condition
+
+	struct Triangle {
+		glm::vec3 a, b, c;
+	};
+
+	struct Ray {
+		glm::vec3 e, d;
+	};
+
+	// Möller–Trumbore in double precision, with the float rounding error to expect
+	struct Exact {
+		bool grazing;      // hit or miss may go either way in float
+		double tolerance;  // on t
+	};
+
+	Exact exact(const Triangle& tri, const Ray& ray) {
+		const double eps = std::numeric_limits<float>::epsilon();
+		glm::dvec3 a(tri.a), e(ray.e), d(ray.d);
+		glm::dvec3 e1 = glm::dvec3(tri.b) - a, e2 = glm::dvec3(tri.c) - a;
+		glm::dvec3 s = e - a;
+		double l1 = glm::length(e1), l2 = glm::length(e2), ls = glm::length(s), ld = glm::length(d);
+		glm::dvec3 q = glm::cross(d, e2);
+		double det = glm::dot(e1, q);
+		if (det == 0.0) { return { true, 0.0 }; }
+		double u = glm::dot(s, q) / det;
+		glm::dvec3 r = glm::cross(s, e1);
+		double v = glm::dot(d, r) / det;
+		double t = glm::dot(e2, r) / det;
+		// error bounds of the float dot/cross products over the determinant (large for near-parallel rays)
+		double bary_tolerance = std::max(s_margin, s_ulps * eps * ld * (ls * l1 + ls * l2 + l1 * l2) / std::abs(det));
+		double t_tolerance = s_ulps * eps * l1 * l2 * (ls + std::abs(t) * ld) / std::abs(det);
+		// signed distance to the closest edge in barycentric units; the ray is inside when it is >= 0
+		double edge = std::min(std::min(u, v), 1.0 - u - v);
+		if (edge < -bary_tolerance) { return { false, 0.0 }; }
+		double bound = std::min(std::abs(t - s_near), std::abs(t - s_far));
+		return { edge < bary_tolerance || bound < std::max(s_margin, t_tolerance), t_tolerance };
+	}
+
+	struct Stats {
+		size_t checked;
+		size_t skipped;
+		size_t hits;
+		size_t mismatches;
+		double max_error;  // |dt| as a fraction of the tolerance
+
+		Stats() : checked{ 0 }, skipped{ 0 }, hits{ 0 }, mismatches{ 0 }, max_error{ 0.0 } { }
+
+		void compare(const char* what, bool hit, float t, std::pair<bool, float> ref, double tolerance) {
+			++checked;
+			hits += ref.first;
+			double error = hit ? std::abs(double(t) - ref.second) : 0.0;
+			if (hit == ref.first && error <= tolerance) {
+				if (hit && tolerance > 0.0) { max_error = std::max(max_error, error / tolerance); }
+				return;
+			}
+			if (++mismatches <= 10) {
+				std::printf("[TEST::RAY KERNEL] MISMATCH %s: hit %d t %.9g, expected hit %d t %.9g (tolerance %.3g)\n",
+					what, (int)hit, t, (int)ref.first, ref.second, tolerance);
+			}
+		}
+
+		void print(const char* what) const {
+			std::printf("[TEST::RAY KERNEL] %-14s || %zu CHECKED (%zu HITS), %zu GRAZING SKIPPED, MAX |dt| %.2f OF TOLERANCE || %s\n",
+				what, checked, hits, skipped, max_error, mismatches ? "FAILED" : "OK");
+		}
+	};
+
+	class Generator {
+	public:
+		explicit Generator(unsigned seed) : m_rng(seed), m_unit(-1.f, 1.f), m_size(0.02f, 0.5f), m_bary(0.f, 1.f) { }
+
+		glm::vec3 point() { return glm::vec3(m_unit(m_rng), m_unit(m_rng), m_unit(m_rng)); }
+
+		Triangle triangle() {
+			glm::vec3 a = point();
+			float size = m_size(m_rng);
+			return { a, a + size * point(), a + size * point() };
+		}
+
+		// Aimed at a point around tri (inside about half the time), from up to a few units away
+		Ray rayAt(const Triangle& tri) {
+			float u = 1.4f * m_bary(m_rng) - 0.2f;
+			float v = (1.4f - u) * m_bary(m_rng) - 0.2f;
+			glm::vec3 target = tri.a + u * (tri.b - tri.a) + v * (tri.c - tri.a);
+			glm::vec3 e = target + 4.f * point();
+			// a few rays start past the triangle or point away from it
+			glm::vec3 d = target - e;
+			if (m_bary(m_rng) < 0.1f) { d = -d; }
+			return { e, m_bary(m_rng) < 0.5f ? glm::normalize(d) : d };
+		}
+
+		int lane() { return std::uniform_int_distribution<int>(0, W - 1)(m_rng); }
+
+	private:
+		std::mt19937 m_rng;
+		std::uniform_real_distribution<float> m_unit;
+		std::uniform_real_distribution<float> m_size;
+		std::uniform_real_distribution<float> m_bary;
+	};
+
+	std::pair<bool, float> reference(const Triangle* tris, int n, const Ray& ray) {
+		std::pair<bool, float> best{ false, s_far };
+		for (int i = 0; i < n; ++i) {
+			auto p = Object::intersectTriangle(tris[i].a, tris[i].b, tris[i].c, ray.e, ray.d, s_near, s_far);
+			if (p.first && (!best.first || p.second < best.second)) {
+				best = p;
+			}
+		}
+		return best;
+	}
+
+	// False if the ray grazes any of the triangles; tolerance is the largest on t among them
+	bool clearOfAll(const Triangle* tris, int n, const Ray& ray, double& tolerance) {
+		for (int i = 0; i < n; ++i) {
+			Exact x = exact(tris[i], ray);
+			if (x.grazing) { return false; }
+			tolerance = std::max(tolerance, x.tolerance);
+		}
+		return true;
+	}
+
+	// One triangle in a random lane, the other lanes empty
+	void testSingleLane(RayKernel::Isa isa, int n_rays, Stats& stats) {
+		Generator gen(1);
+		for (int i = 0; i < n_rays; ++i) {
+			Triangle tri = gen.triangle();
+			Ray ray = gen.rayAt(tri);
+			Exact x = exact(tri, ray);
+			if (x.grazing) { ++stats.skipped; continue; }
+			TrianglePacket packet;
+			RayKernel::clear(packet);
+			RayKernel::pack(packet, gen.lane(), tri.a, tri.b, tri.c);
+			float t = s_far;
+			bool hit = RayKernel::intersect(isa, packet, ray.e, ray.d, s_near, t);
+			stats.compare(RayKernel::name(isa), hit, t, reference(&tri, 1, ray), x.tolerance);
+		}
+	}
+
+	// Full packets, ray aimed at one of the triangles; checks the closest t
+	void testFullPacket(RayKernel::Isa isa, int n_rays, Stats& stats) {
+		Generator gen(2);
+		for (int i = 0; i < n_rays; ++i) {
+			Triangle tris[W];
+			TrianglePacket packet;
+			for (int k = 0; k < W; ++k) {
+				tris[k] = gen.triangle();
+				RayKernel::pack(packet, k, tris[k].a, tris[k].b, tris[k].c);
+			}
+			Ray ray = gen.rayAt(tris[gen.lane()]);
+			double tolerance = 0.0;
+			if (!clearOfAll(tris, W, ray, tolerance)) { ++stats.skipped; continue; }
+			float t = s_far;
+			bool hit = RayKernel::intersect(isa, packet, ray.e, ray.d, s_near, t);
+			stats.compare(RayKernel::name(isa), hit, t, reference(tris, W, ray), tolerance);
+		}
+	}
+
+	// Bvh over a triangle soup against a brute-force loop
+	void testBvh(int n_rays, Stats& stats) {
+		Generator gen(3);
+		std::vector<Triangle> tris(4096);
+		std::vector<glm::vec3> vertices;
+		std::vector<int> indices;
+		for (auto&& tri : tris) {
+			tri = gen.triangle();
+			for (const glm::vec3& p : { tri.a, tri.b, tri.c }) {
+				indices.push_back((int)vertices.size());
+				vertices.push_back(p);
+			}
+		}
+		Bvh bvh;
+		bvh.build(vertices, indices);
+		n_rays = std::max(1, n_rays / 64);
+		for (int i = 0; i < n_rays; ++i) {
+			Ray ray = gen.rayAt(tris[i % tris.size()]);
+			double tolerance = 0.0;
+			if (!clearOfAll(tris.data(), (int)tris.size(), ray, tolerance)) { ++stats.skipped; continue; }
+			auto p = bvh.intersect(ray.e, ray.d, s_near, s_far);
+			stats.compare("BVH", p.first, p.second, reference(tris.data(), (int)tris.size(), ray), tolerance);
+		}
+	}
+
+	double trianglesPerSecond(RayKernel::Isa isa) {
+		Generator gen(4);
+		std::vector<TrianglePacket> packets(1024);
+		for (auto&& packet : packets) {
+			for (int k = 0; k < W; ++k) {
+				Triangle tri = gen.triangle();
+				RayKernel::pack(packet, k, tri.a, tri.b, tri.c);
+			}
+		}
+		std::vector<Ray> rays(256);
+		for (auto&& ray : rays) {
+			ray = gen.rayAt(gen.triangle());
+		}
+		size_t hits = 0;
+		auto t_start = std::chrono::high_resolution_clock::now();
+		for (auto&& ray : rays) {
+			for (auto&& packet : packets) {
+				float t = s_far;
+				hits += RayKernel::intersect(isa, packet, ray.e, ray.d, s_near, t);
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+		volatile size_t sink = hits;
+		(void)sink;
+		return double(rays.size()) * packets.size() * W / seconds;
+	}
+}
+
+int main(int argc, char** argv) {
+	int n_rays = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200000;
+	std::printf("[TEST::RAY KERNEL] DISPATCHED KERNEL: %s\n", RayKernel::isa());
+	bool ok = true;
+	for (int i = 0; i < RayKernel::N_ISA; ++i) {
+		RayKernel::Isa isa = RayKernel::Isa(i);
+		if (!RayKernel::supported(isa)) {
+			std::printf("[TEST::RAY KERNEL] %-14s || NOT SUPPORTED HERE\n", RayKernel::name(isa));
+			continue;
+		}
+		Stats single, full;
+		testSingleLane(isa, n_rays, single);
+		testFullPacket(isa, n_rays, full);
+		single.print((std::string(RayKernel::name(isa)) + " 1 LANE").c_str());
+		full.print((std::string(RayKernel::name(isa)) + " 8 LANES").c_str());
+		ok = ok && !single.mismatches && !full.mismatches;
+	}
+	Stats bvh;
+	testBvh(n_rays, bvh);
+	bvh.print("BVH");
+	ok = ok && !bvh.mismatches;
+
+	for (int i = 0; i < RayKernel::N_ISA; ++i) {
+		RayKernel::Isa isa = RayKernel::Isa(i);
+		if (!RayKernel::supported(isa)) { continue; }
+		std::printf("[BENCHMARK::RAY KERNEL] %-6s || %8.1f M TRIANGLES/s\n", RayKernel::name(isa), trianglesPerSecond(isa) / 1e6);
+	}
+	std::printf("[TEST::RAY KERNEL] %s\n", ok ? "PASSED" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -5,16 +5,36 @@ in vec3 fragPosition;
 
 out vec4 outColor;
 
+// per pass, see FrameBlock in GeometryClass.h
+layout(std140) uniform Frame {
+    mat4 ViewMatrix;
+    mat4 ProjMatrix;
+    mat4 VPMatrix;
+    mat4 AspectRatioMatrix;
+    mat4 shadowMatrices[6];
+    vec3 eyePosition;
+    float far_plane;
+    vec3 lightPosition;
+    bool red_shadow;
+};
+
 //shadow
 uniform samplerCube depthMap;
-uniform float far_plane;
-uniform bool red_shadow;
 
 //lighting
 uniform int lighting_strategy;
-uniform vec3 color;
-uniform vec3 eyePosition;
-uniform vec3 lightPosition; 
+#ifdef INSTANCED
+flat in vec3 instanceColor;
+#define color instanceColor
+#else
+// per object, see ObjectBlock in GeometryClass.h
+layout(std140) uniform Object {
+    mat4 ModelMatrix;
+    mat3 NormalMatrix;
+    vec3 objectColor;
+};
+#define color objectColor
+#endif
 uniform samplerCube skybox;
 
 vec3 gridSamplingDisk[20] = vec3[]
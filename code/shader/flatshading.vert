@@ -4,11 +4,64 @@ in vec3 position;
 
 out vec3 geomPosition;
 
-uniform mat4 AspectRatioMatrix;
-uniform mat4 MVPMatrix;
-uniform mat4 ModelMatrix;
+// per pass, see FrameBlock in GeometryClass.h
+layout(std140) uniform Frame {
+    mat4 ViewMatrix;
+    mat4 ProjMatrix;
+    mat4 VPMatrix;
+    mat4 AspectRatioMatrix;
+    mat4 shadowMatrices[6];
+    vec3 eyePosition;
+    float far_plane;
+    vec3 lightPosition;
+    bool red_shadow;
+};
+
+#ifdef INSTANCED
+in mat4 InstanceModel;
+in vec3 InstanceColor;
+flat out vec3 geomColor;
+#else
+// per object, see ObjectBlock in GeometryClass.h
+layout(std140) uniform Object {
+    mat4 ModelMatrix;
+    mat3 NormalMatrix;
+    vec3 objectColor;
+};
+#endif
+
+#ifdef CUBE_LAYER
+// one instance per cube face set in faceMask, see Geometry::getEnvTexture
+uniform int faceMask;
+uniform mat4 faceMatrices[6];
+
+int cubeFace() {
+    int n = gl_InstanceID;
+    for (int face = 0; face < 6; ++face) {
+        if ((faceMask & (1 << face)) != 0) {
+            if (n == 0) { return face; }
+            --n;
+        }
+    }
+    return 0;
+}
+
+// the geometry shader sets gl_Layer
+flat out int geomFace;
+#endif
 
 void main() {
-    gl_Position = AspectRatioMatrix * MVPMatrix * vec4(position, 1.0);
-    geomPosition = vec3(ModelMatrix * vec4(position, 1.0));
+#ifdef INSTANCED
+    vec4 worldPosition = InstanceModel * vec4(position, 1.0);
+    geomColor = InstanceColor;
+#else
+    vec4 worldPosition = ModelMatrix * vec4(position, 1.0);
+#endif
+#ifdef CUBE_LAYER
+    geomFace = cubeFace();
+    gl_Position = faceMatrices[geomFace] * worldPosition;
+#else
+    gl_Position = AspectRatioMatrix * VPMatrix * worldPosition;
+#endif
+    geomPosition = vec3(worldPosition);
 }
@@ -4,17 +4,39 @@ in vec3 fragNormal;
 in vec3 fragPosition;
 
 out vec4 outColor;
+// screen-space mirrors: world normal and light factor for the resolve pass, 0 elsewhere
+out vec4 outReflect;
+
+// per pass, see FrameBlock in GeometryClass.h
+layout(std140) uniform Frame {
+    mat4 ViewMatrix;
+    mat4 ProjMatrix;
+    mat4 VPMatrix;
+    mat4 AspectRatioMatrix;
+    mat4 shadowMatrices[6];
+    vec3 eyePosition;
+    float far_plane;
+    vec3 lightPosition;
+    bool red_shadow;
+};
 
 //shadow
 uniform samplerCube depthMap;
-uniform float far_plane;
-uniform bool red_shadow;
 
 //lighting
 uniform int lighting_strategy;
-uniform vec3 color;
-uniform vec3 eyePosition;
-uniform vec3 lightPosition; 
+#ifdef INSTANCED
+flat in vec3 instanceColor;
+#define color instanceColor
+#else
+// per object, see ObjectBlock in GeometryClass.h
+layout(std140) uniform Object {
+    mat4 ModelMatrix;
+    mat3 NormalMatrix;
+    vec3 objectColor;
+};
+#define color objectColor
+#endif
 uniform samplerCube skybox;
 
 vec3 gridSamplingDisk[20] = vec3[]
@@ -77,7 +99,8 @@ void phongLighting() {
     outColor = vec4(result, 1.0);
 }
 
-void mirrorLighting() {
+// returns the light factor on the reflection, 0 when painted as red shadow
+float mirrorLighting() {
     // ambient
     vec3 ambient = 0.8 * vec3(1.0, 1.0, 1.0);
 
@@ -87,13 +110,20 @@ void mirrorLighting() {
 
     float shadow = ShadowCalculation(fragPosition);
 
-    vec3 result;
     if (red_shadow && shadow != 0.0) {
-        result = vec3(1.0, 0.0, 0.0);
-    } else {
-        result = (ambient + (1 - shadow)) * texture_color;
+        outColor = vec4(1.0, 0.0, 0.0, 1.0);
+        return 0.0;
+    }
+    outColor = vec4((ambient + (1 - shadow)) * texture_color, 1.0);
+    return ambient.x + (1 - shadow);
+}
+
+// the static mirror, which the resolve pass replaces with whatever it traces on screen
+void screenMirrorLighting() {
+    float light = mirrorLighting();
+    if (light > 0.0) {
+        outReflect = vec4(normalize(fragNormal), light);
     }
-    outColor = vec4(result, 1.0);
 }
 
 void refractLighting() {
@@ -117,11 +147,14 @@ void refractLighting() {
 }
 
 void main() {
+    outReflect = vec4(0.0);
     if (lighting_strategy == 1) {
         phongLighting();
     } else if (lighting_strategy == 2) {
         mirrorLighting();
     } else if (lighting_strategy == 3) {
         refractLighting();
+    } else if (lighting_strategy == 4) {
+        screenMirrorLighting();
     }
 }
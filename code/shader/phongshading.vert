@@ -1,18 +1,90 @@
 #version 150 core
+#ifdef CUBE_LAYER
+// gl_Layer outside the geometry shader
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+#endif
 
 in vec3 position;
+
+#ifdef OCTAHEDRAL_NORMALS
+// unit normal folded onto the octahedron, see VertexFormatClass.cpp
+in vec2 vertex_normal;
+
+vec3 decodeNormal(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#else
 in vec3 vertex_normal;
+#define decodeNormal(n) (n)
+#endif
 
 out vec3 fragPosition;
 out vec3 fragNormal;
 
-uniform mat4 AspectRatioMatrix;
-uniform mat4 MVPMatrix;
-uniform mat4 ModelMatrix;
-uniform mat3 NormalMatrix;
+// per pass, see FrameBlock in GeometryClass.h
+layout(std140) uniform Frame {
+    mat4 ViewMatrix;
+    mat4 ProjMatrix;
+    mat4 VPMatrix;
+    mat4 AspectRatioMatrix;
+    mat4 shadowMatrices[6];
+    vec3 eyePosition;
+    float far_plane;
+    vec3 lightPosition;
+    bool red_shadow;
+};
+
+#ifdef INSTANCED
+in mat4 InstanceModel;
+in mat3 InstanceNormal;
+in vec3 InstanceColor;
+flat out vec3 instanceColor;
+#else
+// per object, see ObjectBlock in GeometryClass.h
+layout(std140) uniform Object {
+    mat4 ModelMatrix;
+    mat3 NormalMatrix;
+    vec3 objectColor;
+};
+#endif
+
+#ifdef CUBE_LAYER
+// one instance per cube face set in faceMask, see Geometry::getEnvTexture
+uniform int faceMask;
+uniform mat4 faceMatrices[6];
+
+int cubeFace() {
+    int n = gl_InstanceID;
+    for (int face = 0; face < 6; ++face) {
+        if ((faceMask & (1 << face)) != 0) {
+            if (n == 0) { return face; }
+            --n;
+        }
+    }
+    return 0;
+}
+#endif
 
 void main() {
-    gl_Position = AspectRatioMatrix * MVPMatrix * vec4(position, 1.0);
-    fragPosition = vec3(ModelMatrix * vec4(position, 1.0));
-    fragNormal = normalize(NormalMatrix * vertex_normal);
+#ifdef INSTANCED
+    vec4 worldPosition = InstanceModel * vec4(position, 1.0);
+    fragNormal = normalize(InstanceNormal * decodeNormal(vertex_normal));
+    instanceColor = InstanceColor;
+#else
+    vec4 worldPosition = ModelMatrix * vec4(position, 1.0);
+    fragNormal = normalize(NormalMatrix * decodeNormal(vertex_normal));
+#endif
+#ifdef CUBE_LAYER
+    int face = cubeFace();
+    gl_Position = faceMatrices[face] * worldPosition;
+    gl_Layer = face;
+#else
+    gl_Position = AspectRatioMatrix * VPMatrix * worldPosition;
+#endif
+    fragPosition = vec3(worldPosition);
 }
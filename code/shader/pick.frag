@@ -0,0 +1,10 @@
+#version 150 core
+
+flat in uint objectId;
+out uvec2 outId;
+
+void main()
+{
+    // 0 stands for "nothing" in both channels
+    outId = uvec2(objectId, uint(gl_PrimitiveID) + 1u);
+}
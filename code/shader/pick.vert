@@ -0,0 +1,25 @@
+#version 150 core
+
+in vec3 position;
+in mat4 InstanceModel;
+in float InstanceObject;
+flat out uint objectId;
+
+// per pass, see FrameBlock in GeometryClass.h
+layout(std140) uniform Frame {
+    mat4 ViewMatrix;
+    mat4 ProjMatrix;
+    mat4 VPMatrix;
+    mat4 AspectRatioMatrix;
+    mat4 shadowMatrices[6];
+    vec3 eyePosition;
+    float far_plane;
+    vec3 lightPosition;
+    bool red_shadow;
+};
+
+void main()
+{
+    gl_Position = AspectRatioMatrix * VPMatrix * InstanceModel * vec4(position, 1.0);
+    objectId = uint(InstanceObject + 0.5) + 1u;
+}
@@ -1,8 +1,18 @@
 #version 150 core
 in vec4 fragPosition;
 
-uniform vec3 lightPosition;
-uniform float far_plane;
+// per pass, see FrameBlock in GeometryClass.h
+layout(std140) uniform Frame {
+    mat4 ViewMatrix;
+    mat4 ProjMatrix;
+    mat4 VPMatrix;
+    mat4 AspectRatioMatrix;
+    mat4 shadowMatrices[6];
+    vec3 eyePosition;
+    float far_plane;
+    vec3 lightPosition;
+    bool red_shadow;
+};
 
 void main()
 {
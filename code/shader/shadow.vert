@@ -1,9 +1,54 @@
 #version 330 core
+#ifdef VERTEX_LAYER
+// gl_Layer outside the geometry shader
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+#endif
 in vec3 position;
 
-uniform mat4 ModelMatrix;
+#ifdef INSTANCED
+in mat4 InstanceModel;
+#else
+// per object, see ObjectBlock in GeometryClass.h
+layout(std140) uniform Object {
+    mat4 ModelMatrix;
+    mat3 NormalMatrix;
+    vec3 objectColor;
+};
+#endif
+
+#ifdef VERTEX_LAYER
+// per pass, see FrameBlock in GeometryClass.h
+layout(std140) uniform Frame {
+    mat4 ViewMatrix;
+    mat4 ProjMatrix;
+    mat4 VPMatrix;
+    mat4 AspectRatioMatrix;
+    mat4 shadowMatrices[6];
+    vec3 eyePosition;
+    float far_plane;
+    vec3 lightPosition;
+    bool red_shadow;
+};
+
+// the cube face this draw renders into
+uniform int shadowFace;
+
+out vec4 fragPosition;
+#endif
 
 void main()
 {
-    gl_Position = ModelMatrix * vec4(position, 1.0);
+#ifdef INSTANCED
+    vec4 world = InstanceModel * vec4(position, 1.0);
+#else
+    vec4 world = ModelMatrix * vec4(position, 1.0);
+#endif
+#ifdef VERTEX_LAYER
+    fragPosition = world;
+    gl_Position = shadowMatrices[shadowFace] * world;
+    gl_Layer = shadowFace;
+#else
+    gl_Position = world;
+#endif
 }
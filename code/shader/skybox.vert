@@ -1,15 +1,55 @@
 #version 150 core
+#ifdef CUBE_LAYER
+// gl_Layer outside the geometry shader
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+#endif
 
 in vec3 position;
 
 out vec3 texture_coordinate;
 
-uniform mat4 AspectRatioMatrix;
-uniform mat4 VPMatrix;
+// per pass, see FrameBlock in GeometryClass.h
+layout(std140) uniform Frame {
+    mat4 ViewMatrix;
+    mat4 ProjMatrix;
+    mat4 VPMatrix;
+    mat4 AspectRatioMatrix;
+    mat4 shadowMatrices[6];
+    vec3 eyePosition;
+    float far_plane;
+    vec3 lightPosition;
+    bool red_shadow;
+};
+
+#ifdef CUBE_LAYER
+// one instance per cube face set in faceMask, see Geometry::getEnvTexture
+uniform int faceMask;
+// rotation only, like the ViewMatrix path below
+uniform mat4 faceMatrices[6];
+
+int cubeFace() {
+    int n = gl_InstanceID;
+    for (int face = 0; face < 6; ++face) {
+        if ((faceMask & (1 << face)) != 0) {
+            if (n == 0) { return face; }
+            --n;
+        }
+    }
+    return 0;
+}
+#endif
 
 void main()
 {
     texture_coordinate = position;
-    vec4 pos = AspectRatioMatrix * VPMatrix * vec4(position, 1.0);
+#ifdef CUBE_LAYER
+    int face = cubeFace();
+    vec4 pos = faceMatrices[face] * vec4(position, 1.0);
+    gl_Layer = face;
+#else
+    // rotation only: the box stays centred on the eye
+    vec4 pos = AspectRatioMatrix * ProjMatrix * mat4(mat3(ViewMatrix)) * vec4(position, 1.0);
+#endif
     gl_Position = pos.xyww;
 }  
@@ -0,0 +1,101 @@
+#version 150 core
+
+in vec2 uv;
+
+out vec4 outColor;
+
+// per pass, see FrameBlock in GeometryClass.h
+layout(std140) uniform Frame {
+    mat4 ViewMatrix;
+    mat4 ProjMatrix;
+    mat4 VPMatrix;
+    mat4 AspectRatioMatrix;
+    mat4 shadowMatrices[6];
+    vec3 eyePosition;
+    float far_plane;
+    vec3 lightPosition;
+    bool red_shadow;
+};
+
+// the main pass, see ReflectionBufferClass.h
+uniform sampler2D sceneColor;
+uniform sampler2D sceneDepth;
+uniform sampler2D sceneReflect;
+uniform samplerCube skybox;
+// inverse of AspectRatioMatrix * VPMatrix
+uniform mat4 inverseViewProj;
+// longest reflected ray, in world units
+uniform float maxDistance;
+
+const int march_steps = 32;
+const int refine_steps = 6;
+// how far behind the depth buffer a hit may lie, in world units
+const float thickness = 0.3;
+
+vec3 worldAt(vec2 coord, float depth) {
+    vec4 p = inverseViewProj * vec4(vec3(coord, depth) * 2.0 - 1.0, 1.0);
+    return p.xyz / p.w;
+}
+
+// uv and depth of a world point; false when it is behind the eye or off screen
+bool screenAt(vec3 world, out vec3 screen) {
+    vec4 clip = AspectRatioMatrix * VPMatrix * vec4(world, 1.0);
+    if (clip.w <= 0.0) {
+        return false;
+    }
+    screen = clip.xyz / clip.w * 0.5 + 0.5;
+    return all(greaterThanEqual(screen, vec3(0.0))) && all(lessThanEqual(screen, vec3(1.0)));
+}
+
+// the ray is behind what the depth buffer shows at its pixel
+bool behind(vec3 screen) {
+    return screen.z > texture(sceneDepth, screen.xy).r;
+}
+
+void main()
+{
+    float depth = texture(sceneDepth, uv).r;
+    vec4 mirror = texture(sceneReflect, uv);
+    gl_FragDepth = depth;
+    if (mirror.w == 0.0) {
+        outColor = texture(sceneColor, uv);
+        return;
+    }
+
+    vec3 position = worldAt(uv, depth);
+    vec3 normal = normalize(mirror.xyz);
+    vec3 R = reflect(normalize(position - eyePosition), normal);
+    vec3 color = texture(skybox, R).rgb;
+
+    // steps grow with the distance, where a pixel covers more of the world
+    vec3 origin = position + normal * 0.01 * length(position - eyePosition);
+    float t0 = 0.0;
+    vec3 screen;
+    for (int i = 1; i <= march_steps; ++i) {
+        float s = float(i) / float(march_steps);
+        float t1 = maxDistance * s * s;
+        if (!screenAt(origin + R * t1, screen)) {
+            break;
+        }
+        if (behind(screen)) {
+            // bisect to the crossing
+            for (int j = 0; j < refine_steps; ++j) {
+                float t = (t0 + t1) * 0.5;
+                screenAt(origin + R * t, screen);
+                if (behind(screen)) { t1 = t; } else { t0 = t; }
+            }
+            screenAt(origin + R * t1, screen);
+            vec3 hit = worldAt(screen.xy, texture(sceneDepth, screen.xy).r);
+            if (length(origin + R * t1 - eyePosition) - length(hit - eyePosition) < thickness) {
+                // fade to the skybox towards the screen border, where the trace runs out
+                vec2 edge = min(screen.xy, 1.0 - screen.xy);
+                float fade = clamp(min(edge.x, edge.y) * 10.0, 0.0, 1.0);
+                color = mix(color, texture(sceneColor, screen.xy).rgb, fade);
+                break;
+            }
+            // passed behind an object: keep going
+        }
+        t0 = t1;
+    }
+    outColor = vec4(mirror.w * color, 1.0);
+}
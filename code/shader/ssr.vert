@@ -0,0 +1,11 @@
+#version 150 core
+
+out vec2 uv;
+
+void main()
+{
+    // one triangle over the whole screen, without a vertex buffer
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    uv = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
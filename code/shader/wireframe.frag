@@ -3,7 +3,18 @@
 out vec4 outColor;
 in vec3 p;
 
-uniform vec3 Color;
+#ifdef INSTANCED
+flat in vec3 instanceColor;
+#define Color instanceColor
+#else
+// per object, see ObjectBlock in GeometryClass.h
+layout(std140) uniform Object {
+    mat4 ModelMatrix;
+    mat3 NormalMatrix;
+    vec3 objectColor;
+};
+#define Color objectColor
+#endif
 
 void main()
 {
@@ -1,13 +1,67 @@
 #version 150 core
+#ifdef CUBE_LAYER
+// gl_Layer outside the geometry shader
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+#endif
 
 in vec3 position;
 out vec3 p;
 
-uniform mat4 AspectRatioMatrix;
-uniform mat4 MVPMatrix;
+// per pass, see FrameBlock in GeometryClass.h
+layout(std140) uniform Frame {
+    mat4 ViewMatrix;
+    mat4 ProjMatrix;
+    mat4 VPMatrix;
+    mat4 AspectRatioMatrix;
+    mat4 shadowMatrices[6];
+    vec3 eyePosition;
+    float far_plane;
+    vec3 lightPosition;
+    bool red_shadow;
+};
+
+#ifdef INSTANCED
+in mat4 InstanceModel;
+in vec3 InstanceColor;
+flat out vec3 instanceColor;
+#else
+// per object, see ObjectBlock in GeometryClass.h
+layout(std140) uniform Object {
+    mat4 ModelMatrix;
+    mat3 NormalMatrix;
+    vec3 objectColor;
+};
+#endif
+
+#ifdef CUBE_LAYER
+// one instance per cube face set in faceMask, see Geometry::getEnvTexture
+uniform int faceMask;
+uniform mat4 faceMatrices[6];
+
+int cubeFace() {
+    int n = gl_InstanceID;
+    for (int face = 0; face < 6; ++face) {
+        if ((faceMask & (1 << face)) != 0) {
+            if (n == 0) { return face; }
+            --n;
+        }
+    }
+    return 0;
+}
+#endif
 
 void main()
 {
-    gl_Position = AspectRatioMatrix * MVPMatrix * vec4(position, 1.0);
+#ifdef INSTANCED
+    gl_Position = AspectRatioMatrix * VPMatrix * InstanceModel * vec4(position, 1.0);
+    instanceColor = InstanceColor;
+#elif defined(CUBE_LAYER)
+    int face = cubeFace();
+    gl_Position = faceMatrices[face] * ModelMatrix * vec4(position, 1.0);
+    gl_Layer = face;
+#else
+    gl_Position = AspectRatioMatrix * VPMatrix * ModelMatrix * vec4(position, 1.0);
+#endif
     p = position;
 }
@@ -43,17 +43,17 @@ namespace SceneEditor {
 			case  GLFW_KEY_1:
 				printf("\n[SYSTEM INFO::INSERTION MODE] || [MODEL] CUBE\n");
 				m_geometry.addCube();
-				printf("[MODE INFO::CUBE] -> CUBE MODEL ADDED TO SCENE.\n");
+				printf("[MODE INFO::CUBE] -> CUBE MODEL QUEUED FOR IMPORT.\n");
 				break;
 			case GLFW_KEY_2:
 				printf("\n[SYSTEM INFO::INSERTION MODE] || [MODEL] BUMPY CUBE\n");
 				m_geometry.addBumpyCube();
-				printf("[MODE INFO::BUMPY CUBE] -> BUMPY CUBE MODEL ADDED TO SCENE.\n");
+				printf("[MODE INFO::BUMPY CUBE] -> BUMPY CUBE MODEL QUEUED FOR IMPORT.\n");
 				break;
 			case  GLFW_KEY_3:
 				printf("\n[SYSTEM INFO::INSERTION MODE] || [MODEL] BUNNY\n");
 				m_geometry.addBunny();
-				printf("[MODE INFO::BUNNY] -> BUNNY MODEL ADDED TO SCENE.\n");
+				printf("[MODE INFO::BUNNY] -> BUNNY MODEL QUEUED FOR IMPORT.\n");
 				break;
 			default:
 				break;
@@ -65,6 +65,8 @@ namespace SceneEditor {
 		: BaseState(geometry, view_control) {}
 
 	MoveState::~MoveState() {
+		// the pick callback refers to this state
+		m_geometry.cancelPick();
 		m_selected = -1;
 	}
 
@@ -72,22 +74,45 @@ namespace SceneEditor {
 		double screen_x, double screen_y) {
 		if (button == GLFW_MOUSE_BUTTON_LEFT) {
 			if (GLFW_PRESS == action) {
-				auto p = view_control.getClickRay(screen_x, screen_y);
-				glm::vec3 e = p.first;
-				glm::vec3 d = p.second;
-				m_selected = m_geometry.intersectRay(e, d,
-					view_control.viewnear(), view_control.viewfar());
-				if (m_selected != -1) {
-					m_geometry[m_selected].inverseColor();
-					std::cout << "Select: " << m_selected << std::endl;
+				m_pressed = true;
+				if (m_geometry.gpuPicking()) {
+					m_geometry.requestPick(view_control, screen_x, screen_y, [this](int object, int triangle) {
+						select(object, triangle);
+					});
+				}
+				else {
+					auto p = view_control.getClickRay(screen_x, screen_y);
+					glm::vec3 e = p.first;
+					glm::vec3 d = p.second;
+					select(m_geometry.intersectRay(e, d,
+						view_control.viewnear(), view_control.viewfar()), -1);
 				}
 			}
 			else if (GLFW_RELEASE == action) {
-				m_geometry[m_selected].inverseColor();
+				m_pressed = false;
+				if (m_highlighted != -1) {
+					m_geometry[m_highlighted].inverseColor();
+					m_highlighted = -1;
+				}
 			}
 		}
 	}
 
+	void MoveState::select(int object, int triangle) {
+		m_selected = object < (int)m_geometry.size() ? object : -1;
+		if (m_selected == -1) { return; }
+		// a GPU pick can land after the button was released
+		if (m_pressed && m_highlighted == -1) {
+			m_geometry[m_selected].inverseColor();
+			m_highlighted = m_selected;
+		}
+		std::cout << "Select: " << m_selected;
+		if (triangle != -1) {
+			std::cout << " (TRIANGLE " << triangle << ")";
+		}
+		std::cout << std::endl;
+	}
+
 	void MoveState::mouseMoveCallback(double screen_x, double screen_y) {
 		//
 	}
@@ -195,6 +220,11 @@ namespace SceneEditor {
 				m_geometry[m_selected].setDisplayMode(Object::MODE8);
 				printf("[MODE INFO] PHONG + MIRROR(DYNAMIC)\n");
 				break;
+			case GLFW_KEY_RIGHT_SHIFT:
+				printf("\n[SYSTEM INFO::DISPLAY MODE] MODE 9 || [STATUS] ACTIVE\n");
+				m_geometry[m_selected].setDisplayMode(Object::MODE9);
+				printf("[MODE INFO] PHONG + MIRROR(SCREEN SPACE)\n");
+				break;
 #define SET_OBJECT_COLOR(xx) \
                 case GLFW_KEY_ ##xx :   \
                     m_geometry[m_selected].color(provided_color[xx - 1]); \
@@ -282,7 +312,9 @@ namespace SceneEditor {
 		ViewControl& view_control)
 		: BaseState(geometry, view_control) {}
 
-	DeleteState::~DeleteState() {}
+	DeleteState::~DeleteState() {
+		m_geometry.cancelPick();
+	}
 
 	/* [MOUSE CONTROLLER]
 	* Selection
@@ -291,19 +323,28 @@ namespace SceneEditor {
 		double screen_x, double screen_y) {
 		if (button == GLFW_MOUSE_BUTTON_LEFT) {
 			if (GLFW_PRESS == action) {
+				if (m_geometry.gpuPicking()) {
+					m_geometry.requestPick(view_control, screen_x, screen_y, [this](int object, int) {
+						remove(object);
+					});
+					return;
+				}
 				auto p = view_control.getClickRay(screen_x, screen_y);
 				glm::vec3 e = p.first;
 				glm::vec3 d = p.second;
-				int selected = m_geometry.intersectRay(e, d,
-					view_control.viewnear(), view_control.viewfar());
-				if (selected != -1) {
-					m_geometry.deleteObject(selected);
-					std::cout << "[SYSTEM INFO::REMOVE MODE] -> DELETED ELEMENT INDEX:" << selected << std::endl;
-				}
+				remove(m_geometry.intersectRay(e, d,
+					view_control.viewnear(), view_control.viewfar()));
 			}
 		}
 	}
 
+	void DeleteState::remove(int selected) {
+		if (selected != -1 && selected < (int)m_geometry.size()) {
+			m_geometry.deleteObject(selected);
+			std::cout << "[SYSTEM INFO::REMOVE MODE] -> DELETED ELEMENT INDEX:" << selected << std::endl;
+		}
+	}
+
 	LightState::LightState(Geometry& geometry,
 		ViewControl& view_control)
 		: BaseState(geometry, view_control) {}
@@ -406,6 +447,9 @@ namespace SceneEditor {
 				toModeLight();
 				printf("\n[SYSTEM INFO::APP MODE] LIGHT MODE || [STATUS] ACTIVE\n");
 				break;
+			case  GLFW_KEY_R:
+				m_geometry.toggleGpuPicking();
+				break;
 			default:
 				break;
 			}
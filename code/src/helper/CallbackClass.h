@@ -38,7 +38,10 @@ namespace SceneEditor {
 		void mouseMoveCallback(double xworld, double yworld) override;
 		void keyboardCallback(int key, int action) override;
 	private:
+		void select(int object, int triangle);
 		int m_selected = -1;
+		int m_highlighted = -1;  // selected object shown inverted while the button is held
+		bool m_pressed = false;
 		static std::vector<glm::vec3> provided_color;
 	};
 
@@ -58,6 +61,8 @@ namespace SceneEditor {
 		virtual ~DeleteState();
 		void mouseClickCallback(int button, int action,
 			double xworld, double yworld) override;
+	private:
+		void remove(int object);
 	};
 
 	class LightState : public BaseState {
@@ -2,6 +2,7 @@
 
 #include "../lib/features/MacroClass.h"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <streambuf>
@@ -46,6 +47,15 @@ std::string ShadowShaders[] = {
 	"shader/shadow.geom" // shadow.geom
 };
 
+/* [PICK SHADER FILES]
+* pick.vert
+* pick.frag
+*/
+std::string PickShaders[] = {
+	"shader/pick.vert", // pick.vert
+	"shader/pick.frag" // pick.frag
+};
+
 /* [SKYBOX SHADER FILES]
 * skybox.vert
 * skybox.frag
@@ -55,6 +65,203 @@ std::string SkyBoxShaders[] = {
 	"shader/skybox.frag" // skybox.frag
 };
 
+/* [SCREEN SPACE REFLECTION SHADER FILES]
+* ssr.vert
+* ssr.frag
+*/
+std::string SsrShaders[] = {
+	"shader/ssr.vert", // ssr.vert
+	"shader/ssr.frag" // ssr.frag
+};
+
+// Fragment outputs besides fragment_data_name (draw buffer 0) and their draw buffers
+static const struct { const char* name; GLuint location; } frag_data_locations[] = {
+	{ "outReflect", 1 }  // screen-space mirrors, see ReflectionBufferClass.h
+};
+
+// Attribute names in the shaders and their VertexAttribLocation
+static const struct { const char* name; GLuint location; } attrib_locations[] = {
+	{ "position", POSITION_ATTRIB },
+	{ "vertex_normal", NORMAL_ATTRIB },
+	{ "InstanceModel", INSTANCE_MODEL_ATTRIB },
+	{ "InstanceNormal", INSTANCE_NORMAL_ATTRIB },
+	{ "InstanceColor", INSTANCE_COLOR_ATTRIB },
+	{ "InstanceObject", INSTANCE_OBJECT_ATTRIB }
+};
+
+// never a valid name, so the next bind always goes through
+static const GLuint unknown_binding = 0xffffffffu;
+
+// a fresh context has everything bound to 0 and fills polygons
+GLuint StateCache::s_program = 0;
+GLuint StateCache::s_vao = 0;
+GLuint StateCache::s_buffers[5] = { 0, 0, 0, 0, 0 };
+GLuint StateCache::s_unit = 0;
+GLuint StateCache::s_textures[StateCache::s_max_texture_units][2] = {};
+GLuint StateCache::s_framebuffer = 0;
+GLuint StateCache::s_polygon_mode = GL_FILL;
+unsigned long long StateCache::s_issued = 0;
+unsigned long long StateCache::s_suppressed = 0;
+
+bool StateCache::change(GLuint& cached, GLuint value)
+{
+	if (cached == value)
+	{
+		++s_suppressed;
+		return false;
+	}
+	cached = value;
+	++s_issued;
+	return true;
+}
+
+GLuint* StateCache::bufferSlot(GLenum target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER: return &s_buffers[0];
+	case GL_ELEMENT_ARRAY_BUFFER: return &s_buffers[1];
+	case GL_UNIFORM_BUFFER: return &s_buffers[2];
+	case GL_PIXEL_PACK_BUFFER: return &s_buffers[3];
+	case GL_PIXEL_UNPACK_BUFFER: return &s_buffers[4];
+	default: return NULL;
+	}
+}
+
+GLuint* StateCache::textureSlot(GLenum target)
+{
+	if (s_unit >= (GLuint)s_max_texture_units)
+		return NULL;
+	switch (target)
+	{
+	case GL_TEXTURE_2D: return &s_textures[s_unit][0];
+	case GL_TEXTURE_CUBE_MAP: return &s_textures[s_unit][1];
+	default: return NULL;
+	}
+}
+
+void StateCache::useProgram(GLuint program)
+{
+	if (change(s_program, program))
+		glUseProgram(program);
+}
+
+void StateCache::bindVertexArray(GLuint vao)
+{
+	if (change(s_vao, vao))
+	{
+		glBindVertexArray(vao);
+		// the element array binding belongs to the VAO
+		s_buffers[1] = unknown_binding;
+	}
+}
+
+void StateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+	GLuint* slot = bufferSlot(target);
+	if (!slot)
+	{
+		++s_issued;
+		glBindBuffer(target, buffer);
+	}
+	else if (change(*slot, buffer))
+		glBindBuffer(target, buffer);
+}
+
+void StateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	// indexed bindings are only set up once, so they are not tracked
+	++s_issued;
+	glBindBufferBase(target, index, buffer);
+	GLuint* slot = bufferSlot(target);
+	if (slot)
+		*slot = buffer;
+}
+
+void StateCache::activeTexture(GLenum unit)
+{
+	if (change(s_unit, unit - GL_TEXTURE0))
+		glActiveTexture(unit);
+}
+
+void StateCache::bindTexture(GLenum target, GLuint texture)
+{
+	GLuint* slot = textureSlot(target);
+	if (!slot)
+	{
+		++s_issued;
+		glBindTexture(target, texture);
+	}
+	else if (change(*slot, texture))
+		glBindTexture(target, texture);
+}
+
+void StateCache::bindFramebuffer(GLuint framebuffer)
+{
+	if (change(s_framebuffer, framebuffer))
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void StateCache::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	++s_issued;
+	glBindFramebuffer(target, framebuffer);
+	s_framebuffer = unknown_binding;
+}
+
+void StateCache::polygonMode(GLenum mode)
+{
+	if (change(s_polygon_mode, mode))
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void StateCache::forgetProgram(GLuint program)
+{
+	if (s_program == program)
+		s_program = unknown_binding;
+}
+
+void StateCache::forgetVertexArray(GLuint vao)
+{
+	if (s_vao == vao)
+		s_vao = unknown_binding;
+}
+
+void StateCache::forgetBuffer(GLuint buffer)
+{
+	for (GLuint& slot : s_buffers)
+		if (slot == buffer)
+			slot = unknown_binding;
+}
+
+void StateCache::forgetTexture(GLuint texture)
+{
+	for (auto& unit : s_textures)
+		for (GLuint& slot : unit)
+			if (slot == texture)
+				slot = unknown_binding;
+}
+
+void StateCache::forgetFramebuffer(GLuint framebuffer)
+{
+	if (s_framebuffer == framebuffer)
+		s_framebuffer = unknown_binding;
+}
+
+void StateCache::invalidate()
+{
+	s_program = unknown_binding;
+	s_vao = unknown_binding;
+	for (GLuint& slot : s_buffers)
+		slot = unknown_binding;
+	s_unit = unknown_binding;
+	for (auto& unit : s_textures)
+		for (GLuint& slot : unit)
+			slot = unknown_binding;
+	s_framebuffer = unknown_binding;
+	s_polygon_mode = unknown_binding;
+}
+
 void VertexArrayObject::init()
 {
 	glGenVertexArrays(1, &id);
@@ -63,12 +270,29 @@ void VertexArrayObject::init()
 
 void VertexArrayObject::bind()
 {
-	glBindVertexArray(id);
+	StateCache::bindVertexArray(id);
+	check_gl_error();
+}
+
+void VertexArrayObject::attribute(GLuint location, VertexBufferObject& VBO)
+{
+	VBO.bind();
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location, VBO.rows, GL_FLOAT, GL_FALSE, 0, 0);
+	check_gl_error();
+}
+
+void VertexArrayObject::attribute(GLuint location, VertexBufferObject& VBO, const VertexAttrib& layout, GLsizei stride)
+{
+	VBO.bind();
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location, layout.size, layout.type, layout.normalized, stride, BUFFER_OFFSET(layout.offset));
 	check_gl_error();
 }
 
 void VertexArrayObject::free()
 {
+	StateCache::forgetVertexArray(id);
 	glDeleteVertexArrays(1, &id);
 	check_gl_error();
 }
@@ -81,19 +305,32 @@ void BufferObject::init()
 
 void BufferObject::free()
 {
+	StateCache::forgetBuffer(id);
 	glDeleteBuffers(1, &id);
 	check_gl_error();
 }
 
 void VertexBufferObject::bind()
 {
-	glBindBuffer(GL_ARRAY_BUFFER, id);
+	StateCache::bindBuffer(GL_ARRAY_BUFFER, id);
 	check_gl_error();
 }
 
 void ElementBufferObject::bind()
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
+	StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
+	check_gl_error();
+}
+
+void UniformBufferObject::bind()
+{
+	StateCache::bindBuffer(GL_UNIFORM_BUFFER, id);
+	check_gl_error();
+}
+
+void UniformBufferObject::bindBase(GLuint binding)
+{
+	StateCache::bindBufferBase(GL_UNIFORM_BUFFER, binding, id);
 	check_gl_error();
 }
 
@@ -103,10 +340,11 @@ void Texture::init() {
 }
 
 void Texture::bind(GLenum target) {
-	glBindTexture(target, id);
+	StateCache::bindTexture(target, id);
 }
 
 void Texture::free() {
+	StateCache::forgetTexture(id);
 	glDeleteTextures(1, &id);
 	check_gl_error();
 }
@@ -117,16 +355,17 @@ void FrameBufferObject::init() {
 }
 
 void FrameBufferObject::bind() {
-	glBindFramebuffer(GL_FRAMEBUFFER, id);
+	StateCache::bindFramebuffer(id);
 	check_gl_error();
 }
 
 void FrameBufferObject::unbind() {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	StateCache::bindFramebuffer(0);
 	check_gl_error();
 }
 
 void FrameBufferObject::free() {
+	StateCache::forgetFramebuffer(id);
 	glDeleteFramebuffers(1, &id);
 	check_gl_error();
 }
@@ -147,6 +386,22 @@ void FrameBufferObject::attach_depth_texture(Texture& texture) {
 	check_gl_error();
 }
 
+void FrameBufferObject::copy_depth_cube(FrameBufferObject& read, FrameBufferObject& draw, Texture& from, Texture& to, int size) {
+	StateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, read.id);
+	StateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, draw.id);
+	// depth only; GL 3.3 calls a framebuffer incomplete if these name a missing color attachment
+	glReadBuffer(GL_NONE);
+	glDrawBuffer(GL_NONE);
+	for (unsigned int i = 0; i < 6; i++) {
+		GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X + i;
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, face, from.id, 0);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, face, to.id, 0);
+		glBlitFramebuffer(0, 0, size, size, 0, 0, size, size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	}
+	StateCache::bindFramebuffer(0);
+	check_gl_error();
+}
+
 void FrameBufferObject::attach_color_texture(Texture& texture) {
 	bind();
 	for (unsigned int i = 0; i < 6; i++) {
@@ -182,6 +437,12 @@ bool Program::init(
 	if (!fragment_data_name.empty()) {
 		glBindFragDataLocation(program_shader, 0, fragment_data_name.c_str());
 	}
+	for (auto&& output : frag_data_locations) {
+		glBindFragDataLocation(program_shader, output.location, output.name);
+	}
+	for (auto&& attrib : attrib_locations) {
+		glBindAttribLocation(program_shader, attrib.location, attrib.name);
+	}
 	glLinkProgram(program_shader);
 
 	GLint status;
@@ -196,28 +457,111 @@ bool Program::init(
 		return false;
 	}
 
+	reflect();
 	check_gl_error();
 	return true;
 }
 
+unsigned long long Program::s_driver_queries = 0;
+
+// Block names in the shaders, indexed by UniformBlockBinding
+static const char* uniform_block_names[N_UNIFORM_BLOCK] = { "Frame", "Object" };
+
+void Program::reflect()
+{
+	m_uniforms.clear();
+	m_attribs.clear();
+	GLint count = 0, max_length = 0;
+	GLint size;
+	GLenum type;
+
+	glGetProgramiv(program_shader, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program_shader, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+	std::vector<char> buffer(max_length + 1);
+	for (GLint i = 0; i < count; ++i)
+	{
+		glGetActiveUniform(program_shader, i, (GLsizei)buffer.size(), NULL, &size, &type, buffer.data());
+		std::string name(buffer.data());
+		GLint location = glGetUniformLocation(program_shader, name.c_str());
+		++s_driver_queries;
+		if (location < 0)
+			continue;  // block members have no location
+		addLocation(m_uniforms, name, location);
+		size_t bracket = name.rfind("[0]");
+		if (bracket != std::string::npos && bracket + 3 == name.size())
+		{
+			// arrays: the bare name and every element
+			std::string base = name.substr(0, bracket);
+			addLocation(m_uniforms, base, location);
+			for (GLint j = 1; j < size; ++j)
+			{
+				std::string element = base + "[" + std::to_string(j) + "]";
+				addLocation(m_uniforms, element, glGetUniformLocation(program_shader, element.c_str()));
+				++s_driver_queries;
+			}
+		}
+	}
+
+	glGetProgramiv(program_shader, GL_ACTIVE_ATTRIBUTES, &count);
+	glGetProgramiv(program_shader, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+	buffer.assign(max_length + 1, 0);
+	for (GLint i = 0; i < count; ++i)
+	{
+		glGetActiveAttrib(program_shader, i, (GLsizei)buffer.size(), NULL, &size, &type, buffer.data());
+		std::string name(buffer.data());
+		GLint location = glGetAttribLocation(program_shader, name.c_str());
+		++s_driver_queries;
+		if (location >= 0)
+			addLocation(m_attribs, name, location);
+	}
+
+	for (GLuint binding = 0; binding < N_UNIFORM_BLOCK; ++binding)
+	{
+		GLuint index = glGetUniformBlockIndex(program_shader, uniform_block_names[binding]);
+		++s_driver_queries;
+		if (index != GL_INVALID_INDEX)
+			glUniformBlockBinding(program_shader, index, binding);
+	}
+
+	std::sort(m_uniforms.begin(), m_uniforms.end());
+	std::sort(m_attribs.begin(), m_attribs.end());
+	for (size_t i = 1; i < m_uniforms.size(); ++i)
+		ASSERT(m_uniforms[i - 1].hash != m_uniforms[i].hash, "Uniform name hash collision");
+	for (size_t i = 1; i < m_attribs.size(); ++i)
+		ASSERT(m_attribs[i - 1].hash != m_attribs[i].hash, "Attribute name hash collision");
+}
+
+void Program::addLocation(std::vector<Location>& table, const std::string& name, GLint location)
+{
+	Location entry = { ShaderName(name).hash, location };
+	table.push_back(entry);
+}
+
+GLint Program::findLocation(const std::vector<Location>& table, uint32_t hash)
+{
+	Location key = { hash, -1 };
+	auto it = std::lower_bound(table.begin(), table.end(), key);
+	return it != table.end() && it->hash == hash ? it->location : -1;
+}
+
 void Program::bind()
 {
-	glUseProgram(program_shader);
+	StateCache::useProgram(program_shader);
 	check_gl_error();
 }
 
-GLint Program::attrib(const std::string& name) const
+GLint Program::attrib(ShaderName name) const
 {
-	return glGetAttribLocation(program_shader, name.c_str());
+	return findLocation(m_attribs, name.hash);
 }
 
-GLint Program::uniform(const std::string& name) const
+GLint Program::uniform(ShaderName name) const
 {
-	return glGetUniformLocation(program_shader, name.c_str());
+	return findLocation(m_uniforms, name.hash);
 }
 
 GLint Program::bindVertexAttribArray(
-	const std::string& name, VertexBufferObject& VBO) const
+	ShaderName name, VertexBufferObject& VBO) const
 {
 	GLint id = attrib(name);
 	if (id < 0)
@@ -235,10 +579,44 @@ GLint Program::bindVertexAttribArray(
 	return id;
 }
 
+GLint Program::bindVertexAttribArray(
+	ShaderName name, VertexBufferObject& VBO, const VertexAttrib& layout, GLsizei stride) const
+{
+	GLint id = attrib(name);
+	if (id < 0)
+		return id;
+	VBO.bind();
+	glEnableVertexAttribArray(id);
+	glVertexAttribPointer(id, layout.size, layout.type, layout.normalized, stride, BUFFER_OFFSET(layout.offset));
+	check_gl_error();
+
+	return id;
+}
+
+GLint Program::bindInstanceAttribArray(ShaderName name, VertexBufferObject& VBO,
+	int n_rows, int n_columns, size_t stride, size_t offset) const
+{
+	GLint id = attrib(name);
+	if (id < 0)
+		return id;
+	VBO.bind();
+	for (int i = 0; i < n_columns; ++i)
+	{
+		glEnableVertexAttribArray(id + i);
+		glVertexAttribPointer(id + i, n_rows, GL_FLOAT, GL_FALSE, (GLsizei)stride,
+			BUFFER_OFFSET(offset + i * n_rows * sizeof(float)));
+		glVertexAttribDivisor(id + i, 1);
+	}
+	check_gl_error();
+
+	return id;
+}
+
 void Program::free()
 {
 	if (program_shader)
 	{
+		StateCache::forgetProgram(program_shader);
 		glDeleteProgram(program_shader);
 		program_shader = 0;
 	}
@@ -288,58 +666,97 @@ GLuint Program::create_shader_helper(GLint type, const std::string& shader_strin
 	return id;
 }
 
-Program ProgramFactory::createWireframeShader(const std::string& fragment_data_name) {
+Program ProgramFactory::createWireframeShader(const std::string& fragment_data_name, bool instanced, bool cube_layer) {
 	Program program;
-	std::string vertex_shader = readShader(WireframeShaders[0]);
-	std::string fragment_shader = readShader(WireframeShaders[1]);
+	std::string defines = cube_layer ? "#define CUBE_LAYER\n" : "";
+	std::string vertex_shader = readShader(WireframeShaders[0], instanced, defines);
+	std::string fragment_shader = readShader(WireframeShaders[1], instanced, defines);
 	std::string geometry_shader;
 	program.init(vertex_shader.data(), fragment_shader.data(), geometry_shader.data(), fragment_data_name);
 	return program;
 }
 
-Program ProgramFactory::createFlatShader(const std::string& fragment_data_name) {
+Program ProgramFactory::createFlatShader(const std::string& fragment_data_name, bool instanced, bool cube_layer) {
 	Program program;
-	std::string vertex_shader = readShader(FlatShaders[0]);
-	std::string fragment_shader = readShader(FlatShaders[1]);
-	std::string geometry_shader = readShader(FlatShaders[2]);
+	std::string defines = cube_layer ? "#define CUBE_LAYER\n" : "";
+	std::string vertex_shader = readShader(FlatShaders[0], instanced, defines);
+	std::string fragment_shader = readShader(FlatShaders[1], instanced, defines);
+	std::string geometry_shader = readShader(FlatShaders[2], instanced, defines);
 	program.init(vertex_shader.data(), fragment_shader.data(), geometry_shader.data(), fragment_data_name);
 	return program;
 }
 
-Program ProgramFactory::createPhongShader(const std::string& fragment_data_name) {
+Program ProgramFactory::createPhongShader(const std::string& fragment_data_name, bool instanced, bool cube_layer) {
 	Program program;
-	std::string vertex_shader = readShader(PhongShaders[0]);
-	std::string fragment_shader = readShader(PhongShaders[1]);
+	std::string defines = cube_layer ? "#define CUBE_LAYER\n" : "";
+	std::string vertex_shader = readShader(PhongShaders[0], instanced, defines);
+	std::string fragment_shader = readShader(PhongShaders[1], instanced, defines);
 	std::string geometry_shader;
 	program.init(vertex_shader.data(), fragment_shader.data(), geometry_shader.data(), fragment_data_name);
 	return program;
 }
 
-Program ProgramFactory::createShadowShader(const std::string& fragment_data_name) {
+Program ProgramFactory::createShadowShader(const std::string& fragment_data_name, bool instanced, bool vertex_layer) {
 	Program program;
-	std::string vertex_shader = readShader(ShadowShaders[0]);
-	std::string fragment_shader = readShader(ShadowShaders[1]);
-	std::string geometry_shader = readShader(ShadowShaders[2]);
+	std::string defines = vertex_layer ? "#define VERTEX_LAYER\n" : "";
+	std::string vertex_shader = readShader(ShadowShaders[0], instanced, defines);
+	std::string fragment_shader = readShader(ShadowShaders[1], instanced, defines);
+	std::string geometry_shader = vertex_layer ? std::string() : readShader(ShadowShaders[2], instanced);
 	program.init(vertex_shader.data(), fragment_shader.data(), geometry_shader.data(), fragment_data_name);
 	program.init(vertex_shader.data(), fragment_shader.data(), geometry_shader.data(), fragment_data_name);
 	return program;
 }
 
-Program ProgramFactory::createSkyboxShader(const std::string& fragment_data_name) {
+Program ProgramFactory::createPickShader(const std::string& fragment_data_name) {
 	Program program;
-	std::string vertex_shader = readShader(SkyBoxShaders[0]);
-	std::string fragment_shader = readShader(SkyBoxShaders[1]);
+	std::string vertex_shader = readShader(PickShaders[0]);
+	std::string fragment_shader = readShader(PickShaders[1]);
 	std::string geometry_shader;
 	program.init(vertex_shader.data(), fragment_shader.data(), geometry_shader.data(), fragment_data_name);
+	return program;
+}
+
+Program ProgramFactory::createSkyboxShader(const std::string& fragment_data_name, bool cube_layer) {
+	Program program;
+	std::string defines = cube_layer ? "#define CUBE_LAYER\n" : "";
+	std::string vertex_shader = readShader(SkyBoxShaders[0], false, defines);
+	std::string fragment_shader = readShader(SkyBoxShaders[1], false, defines);
+	std::string geometry_shader;
+	program.init(vertex_shader.data(), fragment_shader.data(), geometry_shader.data(), fragment_data_name);
+	program.init(vertex_shader.data(), fragment_shader.data(), geometry_shader.data(), fragment_data_name);
+	return program;
+}
+
+Program ProgramFactory::createScreenSpaceReflectionShader(const std::string& fragment_data_name) {
+	Program program;
+	std::string vertex_shader = readShader(SsrShaders[0]);
+	std::string fragment_shader = readShader(SsrShaders[1]);
+	std::string geometry_shader;
 	program.init(vertex_shader.data(), fragment_shader.data(), geometry_shader.data(), fragment_data_name);
 	return program;
 }
 
-std::string ProgramFactory::readShader(const std::string& path) {
+std::string ProgramFactory::s_defines;
+
+void ProgramFactory::define(const std::string& name) {
+	s_defines += "#define " + name + "\n";
+}
+
+std::string ProgramFactory::readShader(const std::string& path, bool instanced, const std::string& extra_defines) {
 	std::ifstream infile(path, std::ios::binary);
 	ASSERT(infile.is_open(), std::string("Shader file not exists: ") + path);
-	return std::string((std::istreambuf_iterator<char>(infile)),
+	std::string source((std::istreambuf_iterator<char>(infile)),
 		std::istreambuf_iterator<char>());
+	std::string defines = s_defines + extra_defines;
+	if (instanced) {
+		defines += "#define INSTANCED\n";
+	}
+	if (!defines.empty()) {
+		// defines have to follow the #version line
+		size_t line_end = source.find('\n');
+		source.insert(line_end == std::string::npos ? source.size() : line_end + 1, defines);
+	}
+	return source;
 }
 
 void _check_gl_error(const char* file, int line)
@@ -362,4 +779,16 @@ void _check_gl_error(const char* file, int line)
 		std::cerr << "GL_" << error.c_str() << " - " << file << ":" << line << std::endl;
 		err = glGetError();
 	}
-}
\ No newline at end of file
+}
+bool has_gl_extension(const char* name)
+{
+	GLint n_extensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &n_extensions);
+	for (GLint i = 0; i < n_extensions; ++i)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+		if (extension && std::string(extension) == name)
+			return true;
+	}
+	return false;
+}
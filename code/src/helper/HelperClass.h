@@ -1,6 +1,7 @@
 #ifndef __HELPERS_H__
 #define __HELPERS_H__
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <glm/glm.hpp>  // glm::vec2
@@ -35,6 +36,105 @@ void _check_gl_error(const char* file, int line);
 
 #define check_gl_error() _check_gl_error(__FILE__,__LINE__)
 
+// True if the current context lists the extension; GLEW may predate it
+bool has_gl_extension(const char* name);
+
+// Name of a shader uniform or attribute, reduced to its FNV-1a hash. Built
+// from a string literal the hash is a constant expression, so lookups at
+// draw time never touch the string or the driver.
+struct ShaderName {
+	template<size_t N>
+	constexpr ShaderName(const char(&name)[N]) : hash{ fnv1a(name) } {}
+	explicit ShaderName(const std::string& name) : hash{ fnv1a(name.c_str()) } {}
+
+	static constexpr uint32_t fnv1a(const char* s, uint32_t h = 2166136261u) {
+		return *s ? fnv1a(s + 1, (h ^ (uint32_t)(unsigned char)*s) * 16777619u) : h;
+	}
+
+	uint32_t hash;
+};
+
+// Binding points of the std140 uniform blocks shared by the shaders; every
+// program has its blocks attached to these when it is linked
+enum UniformBlockBinding {
+	FRAME_BLOCK = 0,   // "Frame": camera and light, updated once per pass
+	OBJECT_BLOCK = 1,  // "Object": model matrices and color, updated per object
+	N_UNIFORM_BLOCK = 2
+};
+
+// Attribute locations fixed before linking, so a VAO recorded once is valid
+// with every program that reads the same attributes
+enum VertexAttribLocation {
+	POSITION_ATTRIB = 0,
+	NORMAL_ATTRIB = 1,           // "vertex_normal"
+	INSTANCE_MODEL_ATTRIB = 2,   // mat4, takes 2..5
+	INSTANCE_NORMAL_ATTRIB = 6,  // mat3, takes 6..8
+	INSTANCE_COLOR_ATTRIB = 9,
+	INSTANCE_OBJECT_ATTRIB = 10
+};
+
+// Shadow copy of the GL binding state. The bind helpers below go through
+// it, so a bind that would leave the state unchanged never reaches the
+// driver. Code binding with raw gl calls has to use it too (or call
+// invalidate()) to keep the copy honest.
+class StateCache {
+public:
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vao);
+	static void bindBuffer(GLenum target, GLuint buffer);
+	// Also sets the generic target binding, like GL does
+	static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	static void activeTexture(GLenum unit);
+	// Binds on the active unit
+	static void bindTexture(GLenum target, GLuint texture);
+	static void bindFramebuffer(GLuint framebuffer);
+	// GL_READ_FRAMEBUFFER or GL_DRAW_FRAMEBUFFER alone; the GL_FRAMEBUFFER pair becomes unknown
+	static void bindFramebuffer(GLenum target, GLuint framebuffer);
+	static void polygonMode(GLenum mode);
+
+	// GL unbinds deleted names and may hand them out again
+	static void forgetProgram(GLuint program);
+	static void forgetVertexArray(GLuint vao);
+	static void forgetBuffer(GLuint buffer);
+	static void forgetTexture(GLuint texture);
+	static void forgetFramebuffer(GLuint framebuffer);
+	// Marks every binding unknown, so the next bind of each kind is issued
+	static void invalidate();
+
+	// Binds passed on to the driver and binds dropped since the last reset
+	static unsigned long long issued() { return s_issued; }
+	static unsigned long long suppressed() { return s_suppressed; }
+	static void resetCounters() { s_issued = 0; s_suppressed = 0; }
+
+private:
+	// Records value and returns true when it differs from cached
+	static bool change(GLuint& cached, GLuint value);
+	static GLuint* bufferSlot(GLenum target);
+	static GLuint* textureSlot(GLenum target);
+
+	static const int s_max_texture_units = 16;
+	static GLuint s_program;
+	static GLuint s_vao;
+	static GLuint s_buffers[5];  // array, element array (per VAO), uniform, pixel pack, pixel unpack
+	static GLuint s_unit;
+	static GLuint s_textures[s_max_texture_units][2];  // 2D, cube map
+	static GLuint s_framebuffer;
+	static GLuint s_polygon_mode;
+	static unsigned long long s_issued;
+	static unsigned long long s_suppressed;
+};
+
+// One attribute inside a vertex buffer: size components of type, starting
+// offset bytes into each vertex
+struct VertexAttrib {
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+	size_t offset;
+};
+
+class VertexBufferObject;
+
 class VertexArrayObject
 {
 public:
@@ -48,6 +148,11 @@ public:
 	// Select this VAO for subsequent draw calls
 	void bind();
 
+	// Record VBO as the per-vertex array at location (this VAO must be bound)
+	void attribute(GLuint location, VertexBufferObject& VBO);
+	// Same for one attribute of an interleaved (or packed) VBO
+	void attribute(GLuint location, VertexBufferObject& VBO, const VertexAttrib& layout, GLsizei stride);
+
 	// Release the id
 	void free();
 };
@@ -92,6 +197,15 @@ public:
 		rows = array[0].length();
 		check_gl_error();
 	};
+	// Updates the BO straight from raw memory, e.g. a section of a mapped file
+	void update(const void* data, size_t size_of_t, size_t array_size, GLuint n_rows) {
+		assert(id != 0);
+		assert(array_size != 0);
+		update_helper(size_of_t, array_size, data);
+		cols = array_size;
+		rows = n_rows;
+		check_gl_error();
+	};
 private:
 	virtual void update_helper(size_t size_of_t, size_t array_size, const void* data) = 0;
 public:
@@ -106,22 +220,38 @@ public:
 	void bind() override;
 private:
 	void update_helper(size_t size_of_t, size_t array_size, const void* data) override {
-		glBindBuffer(GL_ARRAY_BUFFER, id);
+		StateCache::bindBuffer(GL_ARRAY_BUFFER, id);
 		glBufferData(GL_ARRAY_BUFFER, size_of_t * array_size, data, GL_DYNAMIC_DRAW);
 	};
 };
 
 class ElementBufferObject : public BufferObject {
 public:
-	ElementBufferObject() : BufferObject(0) {}
+	ElementBufferObject() : BufferObject(0), type{ GL_UNSIGNED_INT } {}
 	void bind() override;
+
+	GLenum type;  // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, from the last update
 private:
 	void update_helper(size_t size_of_t, size_t array_size, const void* data) override {
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
+		type = size_of_t == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, size_of_t * array_size, data, GL_DYNAMIC_DRAW);
 	};
 };
 
+class UniformBufferObject : public BufferObject {
+public:
+	UniformBufferObject() : BufferObject(0) {}
+	void bind() override;
+	// Attach to an indexed binding point (see UniformBlockBinding)
+	void bindBase(GLuint binding);
+private:
+	void update_helper(size_t size_of_t, size_t array_size, const void* data) override {
+		StateCache::bindBuffer(GL_UNIFORM_BUFFER, id);
+		glBufferData(GL_UNIFORM_BUFFER, size_of_t * array_size, data, GL_DYNAMIC_DRAW);
+	};
+};
+
 class Texture {
 public:
 	typedef unsigned int GLuint;
@@ -148,6 +278,8 @@ public:
 	void check();
 	void attach_depth_texture(Texture& texture);
 	void attach_color_texture(Texture& texture);
+	// Copies all six faces of a depth cube map of size x size, using read and draw as scratch
+	static void copy_depth_cube(FrameBufferObject& read, FrameBufferObject& draw, Texture& from, Texture& to, int size);
 private:
 	GLuint id;
 };
@@ -163,6 +295,11 @@ public:
 	GLuint program_shader;
 	GLuint geometry_shader;
 
+	// Driver name queries (glGet*Location) since the last reset; they only
+	// happen while linking, so this stays at zero in the render loop
+	static unsigned long long driverQueries() { return s_driver_queries; }
+	static void resetCounters() { s_driver_queries = 0; }
+
 	Program() : vertex_shader(0), fragment_shader(0), program_shader(0) { }
 
 	// Create a new shader from the specified source strings
@@ -178,27 +315,62 @@ public:
 	void free();
 
 	// Return the OpenGL handle of a named shader attribute (-1 if it does not exist)
-	GLint attrib(const std::string& name) const;
+	GLint attrib(ShaderName name) const;
 
 	// Return the OpenGL handle of a uniform attribute (-1 if it does not exist)
-	GLint uniform(const std::string& name) const;
+	// Arrays are found by their name ("lights") and by element ("lights[2]")
+	GLint uniform(ShaderName name) const;
 
 	// Bind a per-vertex array attribute
-	GLint bindVertexAttribArray(const std::string& name, VertexBufferObject& VBO) const;
+	GLint bindVertexAttribArray(ShaderName name, VertexBufferObject& VBO) const;
+
+	// Bind one attribute of an interleaved (or packed) per-vertex array
+	GLint bindVertexAttribArray(ShaderName name, VertexBufferObject& VBO, const VertexAttrib& layout, GLsizei stride) const;
+
+	// Bind a per-instance attribute of n_columns float columns with n_rows each (mat4: 4, 4)
+	GLint bindInstanceAttribArray(ShaderName name, VertexBufferObject& VBO,
+		int n_rows, int n_columns, size_t stride, size_t offset) const;
 
 	GLuint create_shader_helper(GLint type, const std::string& shader_string);
 
+private:
+	struct Location {
+		uint32_t hash;
+		GLint location;
+		bool operator<(const Location& other) const { return hash < other.hash; }
+	};
+
+	// Fills m_uniforms and m_attribs from the linked program and attaches its uniform blocks
+	void reflect();
+	static void addLocation(std::vector<Location>& table, const std::string& name, GLint location);
+	static GLint findLocation(const std::vector<Location>& table, uint32_t hash);
+
+	std::vector<Location> m_uniforms;  // sorted by hash
+	std::vector<Location> m_attribs;   // sorted by hash
+	static unsigned long long s_driver_queries;
+
 };
 
 class ProgramFactory {
 public:
-	static Program createWireframeShader(const std::string& fragment_data_name);
-	static Program createFlatShader(const std::string& fragment_data_name);
-	static Program createPhongShader(const std::string& fragment_data_name);
-	static Program createShadowShader(const std::string& fragment_data_name);
-	static Program createSkyboxShader(const std::string& fragment_data_name);
+	// instanced = true compiles the variant that reads per-instance attributes; cube_layer
+	// the one that draws into the cube faces in faceMask, one instance per face
+	static Program createWireframeShader(const std::string& fragment_data_name, bool instanced = false, bool cube_layer = false);
+	static Program createFlatShader(const std::string& fragment_data_name, bool instanced = false, bool cube_layer = false);
+	static Program createPhongShader(const std::string& fragment_data_name, bool instanced = false, bool cube_layer = false);
+	// vertex_layer picks gl_Layer in the vertex shader, one face per draw, instead of the
+	// geometry shader that copies every triangle to all six faces
+	static Program createShadowShader(const std::string& fragment_data_name, bool instanced = false, bool vertex_layer = false);
+	static Program createSkyboxShader(const std::string& fragment_data_name, bool cube_layer = false);
+	// Full-screen resolve of the screen-space mirrors, see ReflectionBuffer
+	static Program createScreenSpaceReflectionShader(const std::string& fragment_data_name);
+	// Object and triangle IDs for GPU picking (always instanced)
+	static Program createPickShader(const std::string& fragment_data_name);
+	// Adds #define name to every shader created afterwards
+	static void define(const std::string& name);
 private:
-	static std::string readShader(const std::string& shader);
+	static std::string readShader(const std::string& shader, bool instanced = false, const std::string& extra_defines = "");
+	static std::string s_defines;
 };
 
 #endif  // __HELPERS_H__
@@ -0,0 +1,250 @@
+#include "AabbTreeClass.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+
+namespace SceneEditor {
+
+	namespace {
+
+		inline float area(const glm::vec3& lo, const glm::vec3& hi) {
+			glm::vec3 e = hi - lo;
+			return 2.f * (e.x * e.y + e.y * e.z + e.z * e.x);
+		}
+
+		inline bool contains(const glm::vec3& outer_lo, const glm::vec3& outer_hi, const glm::vec3& lo, const glm::vec3& hi) {
+			return glm::all(glm::lessThanEqual(outer_lo, lo)) && glm::all(glm::lessThanEqual(hi, outer_hi));
+		}
+
+		inline bool overlaps(const glm::vec3& a_lo, const glm::vec3& a_hi, const glm::vec3& b_lo, const glm::vec3& b_hi) {
+			return glm::all(glm::lessThanEqual(a_lo, b_hi)) && glm::all(glm::lessThanEqual(b_lo, a_hi));
+		}
+
+		inline bool intersectBox(const glm::vec3& lo, const glm::vec3& hi,
+			const glm::vec3& e, const glm::vec3& inv_d, float vnear, float vfar, float& t_enter) {
+			glm::vec3 t0 = (lo - e) * inv_d;
+			glm::vec3 t1 = (hi - e) * inv_d;
+			glm::vec3 t_min = glm::min(t0, t1);
+			glm::vec3 t_max = glm::max(t0, t1);
+			t_enter = std::max(std::max(t_min.x, t_min.y), std::max(t_min.z, vnear));
+			float t_exit = std::min(std::min(t_max.x, t_max.y), std::min(t_max.z, vfar));
+			return t_enter <= t_exit;
+		}
+	}
+
+	const float AabbTree::s_margin = .1f;
+
+	AabbTree::AabbTree() : m_root{ -1 }, m_free{ -1 }, m_leaves{ 0 } {}
+
+	int AabbTree::insert(const glm::vec3& lo, const glm::vec3& hi, int user) {
+		int leaf = allocate();
+		glm::vec3 margin(s_margin * glm::max(glm::max(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z));
+		m_nodes[leaf].lo = lo - margin;
+		m_nodes[leaf].hi = hi + margin;
+		m_nodes[leaf].user = user;
+		insertLeaf(leaf);
+		++m_leaves;
+		return leaf;
+	}
+
+	void AabbTree::remove(int proxy) {
+		removeLeaf(proxy);
+		release(proxy);
+		--m_leaves;
+	}
+
+	bool AabbTree::move(int proxy, const glm::vec3& lo, const glm::vec3& hi) {
+		if (contains(m_nodes[proxy].lo, m_nodes[proxy].hi, lo, hi)) { return false; }
+		removeLeaf(proxy);
+		glm::vec3 margin(s_margin * glm::max(glm::max(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z));
+		m_nodes[proxy].lo = lo - margin;
+		m_nodes[proxy].hi = hi + margin;
+		insertLeaf(proxy);
+		return true;
+	}
+
+	void AabbTree::clear() {
+		m_nodes.clear();
+		m_root = -1;
+		m_free = -1;
+		m_leaves = 0;
+	}
+
+	void AabbTree::raycast(const glm::vec3& e, const glm::vec3& d, float vnear, float vfar, const RayCallback& callback) const {
+		if (m_root < 0) { return; }
+		glm::vec3 inv_d = 1.f / d;
+		std::vector<int> stack;
+		stack.push_back(m_root);
+		while (!stack.empty()) {
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+			float t_enter;
+			if (!intersectBox(node.lo, node.hi, e, inv_d, vnear, vfar, t_enter)) { continue; }
+			if (node.left < 0) {
+				vfar = callback(node.user, vfar);
+				continue;
+			}
+			int first = node.left;
+			int second = node.right;
+			float t_first, t_second;
+			bool hit_first = intersectBox(m_nodes[first].lo, m_nodes[first].hi, e, inv_d, vnear, vfar, t_first);
+			bool hit_second = intersectBox(m_nodes[second].lo, m_nodes[second].hi, e, inv_d, vnear, vfar, t_second);
+			if (hit_first && hit_second && t_second < t_first) {
+				std::swap(first, second);
+				std::swap(hit_first, hit_second);
+			}
+			// push the far child first so the near one is popped next
+			if (hit_second) { stack.push_back(second); }
+			if (hit_first) { stack.push_back(first); }
+		}
+	}
+
+	void AabbTree::query(const glm::vec3& lo, const glm::vec3& hi, const QueryCallback& callback) const {
+		if (m_root < 0) { return; }
+		std::vector<int> stack;
+		stack.push_back(m_root);
+		while (!stack.empty()) {
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+			if (!overlaps(node.lo, node.hi, lo, hi)) { continue; }
+			if (node.left < 0) {
+				callback(node.user);
+				continue;
+			}
+			stack.push_back(node.left);
+			stack.push_back(node.right);
+		}
+	}
+
+	void AabbTree::queryFrustum(const glm::mat4& VPMatrix, const QueryCallback& callback) const {
+		if (m_root < 0) { return; }
+		// clip planes from the rows of VPMatrix (Gribb & Hartmann)
+		glm::mat4 rows = glm::transpose(VPMatrix);
+		glm::vec4 planes[6] = {
+			rows[3] + rows[0], rows[3] - rows[0],
+			rows[3] + rows[1], rows[3] - rows[1],
+			rows[3] + rows[2], rows[3] - rows[2]
+		};
+		std::vector<int> stack;
+		stack.push_back(m_root);
+		while (!stack.empty()) {
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+			bool outside = false;
+			for (int i = 0; i < 6 && !outside; ++i) {
+				// corner furthest along the plane normal
+				glm::vec3 n(planes[i]);
+				glm::vec3 p(n.x > 0.f ? node.hi.x : node.lo.x, n.y > 0.f ? node.hi.y : node.lo.y, n.z > 0.f ? node.hi.z : node.lo.z);
+				outside = glm::dot(n, p) + planes[i].w < 0.f;
+			}
+			if (outside) { continue; }
+			if (node.left < 0) {
+				callback(node.user);
+				continue;
+			}
+			stack.push_back(node.left);
+			stack.push_back(node.right);
+		}
+	}
+
+	int AabbTree::allocate() {
+		int node;
+		if (m_free >= 0) {
+			node = m_free;
+			m_free = m_nodes[node].parent;
+		}
+		else {
+			node = static_cast<int>(m_nodes.size());
+			m_nodes.push_back(Node());
+		}
+		m_nodes[node].parent = -1;
+		m_nodes[node].left = -1;
+		m_nodes[node].right = -1;
+		m_nodes[node].user = -1;
+		return node;
+	}
+
+	void AabbTree::release(int node) {
+		m_nodes[node].parent = m_free;
+		m_free = node;
+	}
+
+	void AabbTree::insertLeaf(int leaf) {
+		if (m_root < 0) {
+			m_root = leaf;
+			m_nodes[leaf].parent = -1;
+			return;
+		}
+
+		// walk down to the sibling with the lowest surface area cost
+		glm::vec3 lo = m_nodes[leaf].lo;
+		glm::vec3 hi = m_nodes[leaf].hi;
+		int index = m_root;
+		while (m_nodes[index].left >= 0) {
+			const Node& node = m_nodes[index];
+			float node_area = area(node.lo, node.hi);
+			float combined = area(glm::min(node.lo, lo), glm::max(node.hi, hi));
+			float cost = 2.f * combined;
+			float inherited = 2.f * (combined - node_area);
+
+			float child_cost[2];
+			int children[2] = { node.left, node.right };
+			for (int i = 0; i < 2; ++i) {
+				const Node& child = m_nodes[children[i]];
+				child_cost[i] = area(glm::min(child.lo, lo), glm::max(child.hi, hi)) + inherited;
+				if (child.left >= 0) { child_cost[i] -= area(child.lo, child.hi); }
+			}
+			if (cost < child_cost[0] && cost < child_cost[1]) { break; }
+			index = child_cost[0] < child_cost[1] ? children[0] : children[1];
+		}
+
+		int sibling = index;
+		int old_parent = m_nodes[sibling].parent;
+		int new_parent = allocate();
+		m_nodes[new_parent].parent = old_parent;
+		m_nodes[new_parent].lo = glm::min(m_nodes[sibling].lo, lo);
+		m_nodes[new_parent].hi = glm::max(m_nodes[sibling].hi, hi);
+		m_nodes[new_parent].left = sibling;
+		m_nodes[new_parent].right = leaf;
+		m_nodes[sibling].parent = new_parent;
+		m_nodes[leaf].parent = new_parent;
+		if (old_parent < 0) {
+			m_root = new_parent;
+		}
+		else {
+			if (m_nodes[old_parent].left == sibling) { m_nodes[old_parent].left = new_parent; }
+			else { m_nodes[old_parent].right = new_parent; }
+			refit(old_parent);
+		}
+	}
+
+	void AabbTree::removeLeaf(int leaf) {
+		if (leaf == m_root) {
+			m_root = -1;
+			return;
+		}
+		int parent = m_nodes[leaf].parent;
+		int grand_parent = m_nodes[parent].parent;
+		int sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+		m_nodes[sibling].parent = grand_parent;
+		if (grand_parent < 0) {
+			m_root = sibling;
+		}
+		else {
+			if (m_nodes[grand_parent].left == parent) { m_nodes[grand_parent].left = sibling; }
+			else { m_nodes[grand_parent].right = sibling; }
+			refit(grand_parent);
+		}
+		release(parent);
+	}
+
+	void AabbTree::refit(int node) {
+		while (node >= 0) {
+			Node& n = m_nodes[node];
+			n.lo = glm::min(m_nodes[n.left].lo, m_nodes[n.right].lo);
+			n.hi = glm::max(m_nodes[n.left].hi, m_nodes[n.right].hi);
+			node = n.parent;
+		}
+	}
+}
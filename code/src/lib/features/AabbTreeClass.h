@@ -0,0 +1,67 @@
+#ifndef __AABB_TREE_H__
+#define __AABB_TREE_H__
+
+#include <glm/vec3.hpp> // glm::vec3
+#include <glm/mat4x4.hpp> // glm::mat4
+
+#include <functional>
+#include <vector>
+
+namespace SceneEditor {
+
+	/* [AABB TREE]
+	* Dynamic bounding volume tree over world-space boxes (one leaf per
+	* object). Leaves store a box enlarged by a margin, so small moves only
+	* update the stored bounds; a leaf is reinserted once its object leaves
+	* the enlarged box. Proxies returned by insert() stay valid until remove().
+	*/
+	class AabbTree {
+	public:
+		AabbTree();
+
+		int insert(const glm::vec3& lo, const glm::vec3& hi, int user);
+		void remove(int proxy);
+		// Returns true if the leaf had to be reinserted
+		bool move(int proxy, const glm::vec3& lo, const glm::vec3& hi);
+		void setUser(int proxy, int user) { m_nodes[proxy].user = user; }
+		int user(int proxy) const { return m_nodes[proxy].user; }
+		void clear();
+		size_t size() const { return m_leaves; }
+
+		// Called for leaves in roughly front-to-back order with the current far
+		// distance; returns the new far distance (e.g. the closest hit so far)
+		typedef std::function<float(int user, float far)> RayCallback;
+		typedef std::function<void(int user)> QueryCallback;
+
+		void raycast(const glm::vec3& e, const glm::vec3& d, float near, float far, const RayCallback& callback) const;
+		void query(const glm::vec3& lo, const glm::vec3& hi, const QueryCallback& callback) const;
+		// Leaves whose box is at least partly inside the clip volume of VPMatrix
+		void queryFrustum(const glm::mat4& VPMatrix, const QueryCallback& callback) const;
+
+	private:
+		struct Node {
+			glm::vec3 lo;
+			glm::vec3 hi;
+			int parent;  // next free node while on the free list
+			int left;    // -1 for leaves
+			int right;
+			int user;
+		};
+
+		int allocate();
+		void release(int node);
+		void insertLeaf(int leaf);
+		void removeLeaf(int leaf);
+		void refit(int node);
+
+	private:
+		static const float s_margin;  // fraction of the box extent
+
+		std::vector<Node> m_nodes;
+		int m_root;
+		int m_free;
+		size_t m_leaves;
+	};
+}
+
+#endif // __AABB_TREE_H__
@@ -0,0 +1,245 @@
+#include "BvhClass.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace SceneEditor {
+
+	namespace {
+
+		const int s_bins = 12;
+		// a leaf is tested with one packet call, so leaves are filled up to its width
+		const int s_max_leaf = TrianglePacket::s_width;
+		// subtrees at least this large are built on their own thread
+		const size_t s_parallel_triangles = 1 << 16;
+		const int s_max_parallel_depth = 3;
+
+		struct Box {
+			glm::vec3 lo;
+			glm::vec3 hi;
+
+			Box() : lo(std::numeric_limits<float>::max()), hi(std::numeric_limits<float>::lowest()) {}
+
+			void grow(const glm::vec3& p) {
+				lo = glm::min(lo, p);
+				hi = glm::max(hi, p);
+			}
+
+			void grow(const Box& b) {
+				lo = glm::min(lo, b.lo);
+				hi = glm::max(hi, b.hi);
+			}
+
+			float area() const {
+				glm::vec3 e = hi - lo;
+				if (e.x < 0.f) { return 0.f; }
+				return 2.f * (e.x * e.y + e.y * e.z + e.z * e.x);
+			}
+		};
+
+		inline bool intersectBox(const glm::vec3& lo, const glm::vec3& hi,
+			const glm::vec3& e, const glm::vec3& inv_d, float vnear, float vfar, float& t_enter) {
+			glm::vec3 t0 = (lo - e) * inv_d;
+			glm::vec3 t1 = (hi - e) * inv_d;
+			glm::vec3 t_min = glm::min(t0, t1);
+			glm::vec3 t_max = glm::max(t0, t1);
+			t_enter = std::max(std::max(t_min.x, t_min.y), std::max(t_min.z, vnear));
+			float t_exit = std::min(std::min(t_max.x, t_max.y), std::min(t_max.z, vfar));
+			return t_enter <= t_exit;
+		}
+	}
+
+	struct Bvh::Builder {
+		std::vector<Box> bounds;
+		std::vector<glm::vec3> centroids;
+		std::vector<int>& triangles;
+
+		explicit Builder(std::vector<int>& triangles) : triangles(triangles) {}
+
+		// Appends the subtree over triangles[begin, end) to nodes, root first
+		void build(size_t begin, size_t end, std::vector<Node>& nodes, int depth) {
+			size_t index = nodes.size();
+			nodes.push_back(Node());
+			Box box, centroid_box;
+			for (size_t i = begin; i < end; ++i) {
+				box.grow(bounds[triangles[i]]);
+				centroid_box.grow(centroids[triangles[i]]);
+			}
+			nodes[index].lo = box.lo;
+			nodes[index].hi = box.hi;
+
+			size_t n = end - begin;
+			if (n <= s_max_leaf) {
+				nodes[index].offset = static_cast<int>(begin);
+				nodes[index].count = static_cast<int>(n);
+				return;
+			}
+			int axis = -1;
+			int split_bin = 0;
+			float best_cost = std::numeric_limits<float>::max();
+			findSplit(begin, end, centroid_box, box.area(), axis, split_bin, best_cost);
+
+			size_t mid = begin;
+			if (axis >= 0) {
+				float lo = centroid_box.lo[axis];
+				float scale = s_bins / (centroid_box.hi[axis] - lo);
+				auto it = std::partition(triangles.begin() + begin, triangles.begin() + end, [&](int t) {
+					int bin = std::min(s_bins - 1, static_cast<int>((centroids[t][axis] - lo) * scale));
+					return bin <= split_bin;
+				});
+				mid = it - triangles.begin();
+			}
+			if (mid == begin || mid == end) {
+				// degenerate split: fall back to the median along the widest axis
+				glm::vec3 extent = centroid_box.hi - centroid_box.lo;
+				int a = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+				mid = begin + n / 2;
+				std::nth_element(triangles.begin() + begin, triangles.begin() + mid, triangles.begin() + end,
+					[&](int l, int r) { return centroids[l][a] < centroids[r][a]; });
+			}
+
+			if (n >= s_parallel_triangles && depth < s_max_parallel_depth) {
+				std::vector<Node> right;
+				std::thread worker([&] { build(mid, end, right, depth + 1); });
+				build(begin, mid, nodes, depth + 1);
+				worker.join();
+				int offset = static_cast<int>(nodes.size());
+				for (auto&& node : right) {
+					if (node.count == 0) { node.offset += offset; }
+					nodes.push_back(node);
+				}
+				nodes[index].offset = offset;
+			}
+			else {
+				build(begin, mid, nodes, depth + 1);
+				nodes[index].offset = static_cast<int>(nodes.size());
+				build(mid, end, nodes, depth + 1);
+			}
+			nodes[index].count = 0;
+		}
+
+		void findSplit(size_t begin, size_t end, const Box& centroid_box, float parent_area,
+			int& best_axis, int& best_bin, float& best_cost) {
+			if (parent_area <= 0.f) { return; }
+			for (int axis = 0; axis < 3; ++axis) {
+				float lo = centroid_box.lo[axis];
+				float extent = centroid_box.hi[axis] - lo;
+				if (extent <= 0.f) { continue; }
+				float scale = s_bins / extent;
+
+				Box bin_box[s_bins];
+				int bin_count[s_bins] = { 0 };
+				for (size_t i = begin; i < end; ++i) {
+					int t = triangles[i];
+					int bin = std::min(s_bins - 1, static_cast<int>((centroids[t][axis] - lo) * scale));
+					bin_box[bin].grow(bounds[t]);
+					++bin_count[bin];
+				}
+
+				// sweep from the right to get the cost of every plane in one pass
+				float right_area[s_bins];
+				int right_count[s_bins];
+				Box acc;
+				int count = 0;
+				for (int b = s_bins - 1; b > 0; --b) {
+					acc.grow(bin_box[b]);
+					count += bin_count[b];
+					right_area[b] = acc.area();
+					right_count[b] = count;
+				}
+				acc = Box();
+				count = 0;
+				for (int b = 0; b < s_bins - 1; ++b) {
+					acc.grow(bin_box[b]);
+					count += bin_count[b];
+					if (count == 0 || right_count[b + 1] == 0) { continue; }
+					float cost = 1.f + (acc.area() * count + right_area[b + 1] * right_count[b + 1]) / parent_area;
+					if (cost < best_cost) {
+						best_cost = cost;
+						best_axis = axis;
+						best_bin = b;
+					}
+				}
+			}
+		}
+	};
+
+	void Bvh::build(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices) {
+		clear();
+		size_t n = indices.size() / 3;
+		if (n == 0) { return; }
+		std::vector<int> triangles(n);
+		Builder builder(triangles);
+		builder.bounds.resize(n);
+		builder.centroids.resize(n);
+		for (size_t i = 0; i < n; ++i) {
+			triangles[i] = static_cast<int>(i);
+			Box box;
+			box.grow(vertices[indices[3 * i]]);
+			box.grow(vertices[indices[3 * i + 1]]);
+			box.grow(vertices[indices[3 * i + 2]]);
+			builder.bounds[i] = box;
+			builder.centroids[i] = (box.lo + box.hi) * .5f;
+		}
+		m_nodes.reserve(2 * n / s_max_leaf + 1);
+		builder.build(0, n, m_nodes, 0);
+
+		// leaves point at their packet from here on
+		for (auto&& node : m_nodes) {
+			if (node.count == 0) { continue; }
+			TrianglePacket packet;
+			RayKernel::clear(packet);
+			for (int lane = 0; lane < node.count; ++lane) {
+				int tri = 3 * triangles[node.offset + lane];
+				RayKernel::pack(packet, lane, vertices[indices[tri]], vertices[indices[tri + 1]], vertices[indices[tri + 2]]);
+			}
+			node.offset = static_cast<int>(m_packets.size());
+			m_packets.push_back(packet);
+		}
+	}
+
+	void Bvh::clear() {
+		m_nodes.clear();
+		m_packets.clear();
+	}
+
+	std::pair<bool, float> Bvh::intersect(const glm::vec3& e, const glm::vec3& d, float vnear, float vfar) const {
+		if (m_nodes.empty()) { return { false, 0.f }; }
+		glm::vec3 inv_d = 1.f / d;
+		float best = vfar;
+		bool hit = false;
+
+		std::vector<int> stack;
+		stack.reserve(64);
+		stack.push_back(0);
+		while (!stack.empty()) {
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+			float t_enter;
+			if (!intersectBox(node.lo, node.hi, e, inv_d, vnear, best, t_enter)) { continue; }
+			if (node.count > 0) {
+				if (RayKernel::intersect(m_packets[node.offset], e, d, vnear, best)) {
+					hit = true;
+				}
+				continue;
+			}
+			int left = static_cast<int>(&node - m_nodes.data()) + 1;
+			int right = node.offset;
+			// visit the nearer child first so the far one is often culled by best
+			float t_left, t_right;
+			bool hit_left = intersectBox(m_nodes[left].lo, m_nodes[left].hi, e, inv_d, vnear, best, t_left);
+			bool hit_right = intersectBox(m_nodes[right].lo, m_nodes[right].hi, e, inv_d, vnear, best, t_right);
+			if (hit_left && hit_right) {
+				if (t_left < t_right) { std::swap(left, right); }
+				stack.push_back(left);
+				stack.push_back(right);
+			}
+			else if (hit_left) { stack.push_back(left); }
+			else if (hit_right) { stack.push_back(right); }
+		}
+		return { hit, best };
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef __BVH_H__
+#define __BVH_H__
+
+#include "RayKernelClass.h"
+
+#include <glm/vec3.hpp> // glm::vec3
+
+#include <utility>
+#include <vector>
+
+namespace SceneEditor {
+
+	/* [BVH]
+	* Bounding volume hierarchy over the triangles of one mesh, built with
+	* binned SAH in the mesh's own (object) space. Nodes are stored depth
+	* first: an inner node's left child follows it directly, the right child
+	* sits at node.offset. A leaf holds at most one TrianglePacket worth of
+	* triangles (node.count), stored in m_packets[node.offset].
+	*/
+	class Bvh {
+	public:
+		struct Node {
+			glm::vec3 lo;
+			int offset;
+			glm::vec3 hi;
+			int count;   // 0 for inner nodes
+		};
+
+		void build(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices);
+		void clear();
+		bool empty() const { return m_nodes.empty(); }
+
+		// Closest hit with t in [near, far] of the object-space ray e + t * d
+		std::pair<bool, float> intersect(const glm::vec3& e, const glm::vec3& d, float near, float far) const;
+
+		const std::vector<Node>& nodes() const { return m_nodes; }
+		const std::vector<TrianglePacket>& packets() const { return m_packets; }
+
+	private:
+		struct Builder;
+
+		std::vector<Node> m_nodes;
+		std::vector<TrianglePacket> m_packets;  // one per leaf
+	};
+}
+
+#endif // __BVH_H__
@@ -0,0 +1,197 @@
+#include "ImporterClass.h"
+#include "MeshClass.h"
+#include "MeshOptimizerClass.h"
+
+#include <glm/common.hpp> // glm::min, glm::max
+
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+
+namespace SceneEditor {
+
+	Importer::Importer()
+		: m_to_parse{ s_submit_capacity }
+		, m_to_clean{ s_stage_capacity }
+		, m_to_normal{ s_stage_capacity }
+		, m_to_optimize{ s_stage_capacity }
+		, m_to_lod{ s_stage_capacity }
+		, m_to_picking{ s_stage_capacity }
+		, m_in_flight{ 0 }
+		, m_running{ false } {}
+
+	Importer::~Importer() {
+		stop();
+	}
+
+	void Importer::start() {
+		if (m_running) { return; }
+		m_running = true;
+		m_workers.emplace_back(&Importer::parseStage, this);
+		m_workers.emplace_back(&Importer::cleanStage, this);
+		m_workers.emplace_back(&Importer::normalStage, this);
+		m_workers.emplace_back(&Importer::optimizeStage, this);
+		m_workers.emplace_back(&Importer::lodStage, this);
+		m_workers.emplace_back(&Importer::pickingStage, this);
+	}
+
+	void Importer::stop() {
+		if (!m_running) { return; }
+		m_running = false;
+		m_to_parse.close();
+		m_to_clean.close();
+		m_to_normal.close();
+		m_to_optimize.close();
+		m_to_lod.close();
+		m_to_picking.close();
+		for (auto&& worker : m_workers) {
+			worker.join();
+		}
+		m_workers.clear();
+	}
+
+	void Importer::submit(const std::string& path, bool allow_shared) {
+		MeshData::ptr mesh(new MeshData());
+		mesh->path = path;
+		mesh->allow_shared = allow_shared;
+		++m_in_flight;
+		if (!m_to_parse.push(std::move(mesh))) {
+			--m_in_flight;
+		}
+	}
+
+	bool Importer::poll(MeshData::ptr& mesh) {
+		if (!m_done.pop(mesh)) { return false; }
+		--m_in_flight;
+		return true;
+	}
+
+	// [PARSE] registry and cache lookup, falling back to the text reader
+	void Importer::parseStage() {
+		MeshData::ptr mesh;
+		while (m_to_parse.pop(mesh)) {
+			try {
+				mesh->source_hash = MeshCache::hashFile(mesh->path);
+				ASSERT(mesh->source_hash != 0, std::string("Mesh file not exists: ") + mesh->path);
+				std::unique_ptr<MeshCache> cache(new MeshCache());
+				if (mesh->allow_shared && m_lookup && m_lookup(mesh->path, mesh->source_hash)) {
+					mesh->shared = true;
+				}
+				else if (cache->load(mesh->path, mesh->source_hash, m_format)) {
+					// picking needs a CPU copy; the GPU upload reads the mapping
+					mesh->vertices.assign(cache->positions(), cache->positions() + cache->vertexCount());
+					mesh->indices.assign(cache->indices(), cache->indices() + cache->indexCount());
+					mesh->lods.resize(cache->lodCount());
+					for (size_t i = 0; i < mesh->lods.size(); ++i) {
+						const MeshCacheLod& lod = cache->lods()[i];
+						mesh->lods[i].first = lod.first;
+						mesh->lods[i].count = lod.count;
+						mesh->lods[i].error = lod.error;
+						mesh->lods[i].first_meshlet = lod.first_meshlet;
+						mesh->lods[i].meshlet_count = lod.meshlet_count;
+					}
+					mesh->meshlets.assign(cache->meshlets(), cache->meshlets() + cache->meshletCount());
+					mesh->closed = cache->closed();
+					mesh->cache = std::move(cache);
+				}
+				else {
+					Mesh::read(mesh->path, mesh->vertices, mesh->indices);
+				}
+			}
+			catch (const std::exception& e) {
+				mesh->error = e.what();
+			}
+			m_to_clean.push(std::move(mesh));
+		}
+	}
+
+	// [CLEAN] weld vertices, drop degenerate and duplicate triangles and unused vertices
+	void Importer::cleanStage() {
+		MeshData::ptr mesh;
+		while (m_to_clean.pop(mesh)) {
+			if (mesh->error.empty() && !mesh->shared && !mesh->cache) {
+				Mesh::CleanStats stats = Mesh::clean(mesh->vertices, mesh->indices);
+				printf("[SYSTEM INFO::MESH LOADER] %s || CLEANUP: %zu WELDED, %zu DEGENERATE, %zu DUPLICATE, %zu UNREFERENCED (%zu -> %zu VERTICES) IN %.3f ms\n",
+					mesh->path.c_str(), stats.welded, stats.degenerate, stats.duplicate, stats.unreferenced,
+					stats.vertices_before, stats.vertices_after, stats.ms);
+			}
+			m_to_normal.push(std::move(mesh));
+		}
+	}
+
+	// [NORMALS] vertex normals and unitize
+	void Importer::normalStage() {
+		MeshData::ptr mesh;
+		while (m_to_normal.pop(mesh)) {
+			if (mesh->error.empty() && !mesh->shared && !mesh->cache) {
+				Mesh::computeNormals(mesh->vertices, mesh->indices, mesh->normals);
+				Mesh::unitize(mesh->vertices);
+			}
+			m_to_optimize.push(std::move(mesh));
+		}
+	}
+
+	// [OPTIMIZE] draw order for the vertex cache and overdraw; cached meshes are stored optimized
+	void Importer::optimizeStage() {
+		MeshData::ptr mesh;
+		while (m_to_optimize.pop(mesh)) {
+			if (mesh->error.empty() && !mesh->shared && !mesh->cache) {
+				MeshOptimizer::Stats stats = MeshOptimizer::optimize(mesh->vertices, mesh->normals, mesh->indices);
+				printf("[SYSTEM INFO::MESH LOADER] %s || ACMR %.3f -> %.3f (CACHE %d), %zu CLUSTERS IN %.3f ms\n",
+					mesh->path.c_str(), stats.acmr_before, stats.acmr_after, MeshOptimizer::s_cache_size, stats.clusters, stats.ms);
+			}
+			m_to_lod.push(std::move(mesh));
+		}
+	}
+
+	// [LOD] simplified index buffers over the same vertices, then the cache write; cached meshes have them already
+	void Importer::lodStage() {
+		MeshData::ptr mesh;
+		while (m_to_lod.pop(mesh)) {
+			if (mesh->error.empty() && !mesh->shared && !mesh->cache) {
+				auto t_start = std::chrono::high_resolution_clock::now();
+				MeshSimplifier::buildChain(mesh->vertices, mesh->indices, MeshSimplifier::s_lod_ratios,
+					mesh->lod_indices, mesh->lods);
+				Meshlets::build(mesh->vertices, mesh->indices, mesh->lod_indices, mesh->lods, mesh->meshlets);
+				mesh->closed = Meshlets::closed(mesh->indices);
+				auto t_end = std::chrono::high_resolution_clock::now();
+				std::string levels;
+				for (auto&& lod : mesh->lods) {
+					char level[64];
+					snprintf(level, sizeof(level), "%s%zu (%.4f)", levels.empty() ? "" : " / ", lod.count / 3, lod.error);
+					levels += level;
+				}
+				printf("[SYSTEM INFO::MESH LOADER] %s || LOD TRIANGLES (ERROR) %s, %zu MESHLETS%s IN %.3f ms\n", mesh->path.c_str(), levels.c_str(),
+					mesh->meshlets.size(), mesh->closed ? " (CLOSED)" : "",
+					std::chrono::duration<double, std::milli>(t_end - t_start).count());
+				MeshCache::write(mesh->path, mesh->source_hash, m_format, mesh->vertices, mesh->normals, mesh->indices,
+					mesh->lod_indices, mesh->lods, mesh->meshlets, mesh->closed);
+			}
+			m_to_picking.push(std::move(mesh));
+		}
+	}
+
+	// [PICKING] bounds used for ray rejection
+	void Importer::pickingStage() {
+		MeshData::ptr mesh;
+		while (m_to_picking.pop(mesh)) {
+			glm::vec3 lo(std::numeric_limits<float>::max());
+			glm::vec3 hi(std::numeric_limits<float>::lowest());
+			for (auto&& v : mesh->vertices) {
+				lo = glm::min(lo, v);
+				hi = glm::max(hi, v);
+			}
+			mesh->bounds_min = lo;
+			mesh->bounds_max = hi;
+			if (!mesh->shared) {
+				mesh->bvh.build(mesh->vertices, mesh->indices);
+			}
+			// the ring is bounded too: wait for the render thread to catch up
+			while (!m_done.push(std::move(mesh))) {
+				if (!m_running) { return; }
+				std::this_thread::yield();
+			}
+		}
+	}
+}
@@ -0,0 +1,101 @@
+#ifndef __IMPORTER_H__
+#define __IMPORTER_H__
+
+#include "BvhClass.h"
+#include "MeshCacheClass.h"
+#include "MeshSimplifierClass.h"
+#include "MeshletClass.h"
+#include "QueueClass.h"
+
+#include <glm/vec3.hpp> // glm::vec3
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SceneEditor {
+
+	// CPU side of a mesh on its way from disk to the GPU
+	struct MeshData {
+		typedef std::unique_ptr<MeshData> ptr;
+
+		std::string path;
+		uint64_t source_hash = 0;
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec3> normals;
+		std::vector<int> indices;
+		// coarser levels over the same vertices, built by the LOD stage; lods[0] is indices
+		std::vector<int> lod_indices;
+		std::vector<MeshLod> lods;
+		// culling clusters of the large levels, see MeshLod::first_meshlet
+		std::vector<Meshlet> meshlets;
+		bool closed = false;  // every edge has two faces, so back-facing meshlets can go
+		glm::vec3 bounds_min;
+		glm::vec3 bounds_max;
+		Bvh bvh;  // object-space picking structure, built by the picking stage
+		// set when the mesh came from a valid cache; normals, lod_indices and the GPU streams are then only in here
+		std::unique_ptr<MeshCache> cache;
+		// set when a live asset with the same path and hash exists; nothing is loaded
+		bool shared = false;
+		bool allow_shared = true;
+		std::string error;
+	};
+
+	/* [IMPORTER]
+	* Background mesh import: parse -> clean -> normals -> optimize -> LOD -> picking.
+	* Every stage runs on its own worker thread and hands over through a
+	* bounded queue. Finished meshes reach the render thread through a
+	* lock-free queue; only the GL upload is left for the caller of poll().
+	*/
+	class Importer {
+	public:
+		Importer();
+		~Importer();
+
+		void start();
+		void stop();
+
+		typedef std::function<bool(const std::string& path, uint64_t source_hash)> Lookup;
+
+		// Tells the parse stage which meshes are already loaded; must be thread-safe
+		void setLookup(const Lookup& lookup) { m_lookup = lookup; }
+		// GPU layout the caches are written and accepted in; set before start()
+		void setVertexFormat(const VertexFormat& format) { m_format = format; }
+		// Queues an OFF file for import (unitized, like addObjFromOffFile)
+		void submit(const std::string& path, bool allow_shared = true);
+		// Render thread: takes one finished mesh, if any
+		bool poll(MeshData::ptr& mesh);
+		// Meshes submitted but not yet handed out by poll()
+		int inFlight() const { return m_in_flight.load(); }
+
+	private:
+		void parseStage();
+		void cleanStage();
+		void normalStage();
+		void optimizeStage();
+		void lodStage();
+		void pickingStage();
+
+	private:
+		static const size_t s_submit_capacity = 64;
+		static const size_t s_stage_capacity = 4;
+
+		BoundedQueue<MeshData::ptr> m_to_parse;
+		BoundedQueue<MeshData::ptr> m_to_clean;
+		BoundedQueue<MeshData::ptr> m_to_normal;
+		BoundedQueue<MeshData::ptr> m_to_optimize;
+		BoundedQueue<MeshData::ptr> m_to_lod;
+		BoundedQueue<MeshData::ptr> m_to_picking;
+		SpscQueue<MeshData::ptr, 16> m_done;
+		std::vector<std::thread> m_workers;
+		std::atomic<int> m_in_flight;
+		std::atomic<bool> m_running;
+		Lookup m_lookup;
+		VertexFormat m_format;
+	};
+}
+
+#endif // __IMPORTER_H__
@@ -0,0 +1,106 @@
+#include "MappedFileClass.h"
+
+#ifdef _WIN32
+#  include <windows.h>
+#  undef max
+#  undef min
+#else
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace SceneEditor {
+
+	MappedFile::MappedFile() : m_data{ nullptr }, m_size{ 0 }, m_open_empty{ false }
+#ifdef _WIN32
+		, m_file{ nullptr }, m_mapping{ nullptr }
+#endif
+	{}
+
+	MappedFile::MappedFile(const std::string& path) : MappedFile() {
+		open(path);
+	}
+
+	MappedFile::~MappedFile() {
+		close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::open(const std::string& path) {
+		close();
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE) { return false; }
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) {
+			CloseHandle(file);
+			return false;
+		}
+		if (size.QuadPart == 0) {
+			CloseHandle(file);
+			m_open_empty = true;
+			return true;
+		}
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL) {
+			CloseHandle(file);
+			return false;
+		}
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == NULL) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		m_file = file;
+		m_mapping = mapping;
+		m_data = static_cast<const char*>(view);
+		m_size = static_cast<size_t>(size.QuadPart);
+		return true;
+	}
+
+	void MappedFile::close() {
+		if (m_data) { UnmapViewOfFile(m_data); }
+		if (m_mapping) { CloseHandle(m_mapping); }
+		if (m_file) { CloseHandle(m_file); }
+		m_data = nullptr;
+		m_mapping = nullptr;
+		m_file = nullptr;
+		m_size = 0;
+		m_open_empty = false;
+	}
+#else
+	bool MappedFile::open(const std::string& path) {
+		close();
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) { return false; }
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			::close(fd);
+			return false;
+		}
+		if (st.st_size == 0) {
+			::close(fd);
+			m_open_empty = true;
+			return true;
+		}
+		void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		// the mapping keeps its own reference to the file
+		::close(fd);
+		if (view == MAP_FAILED) { return false; }
+		madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+		m_data = static_cast<const char*>(view);
+		m_size = static_cast<size_t>(st.st_size);
+		return true;
+	}
+
+	void MappedFile::close() {
+		if (m_data) { munmap(const_cast<char*>(m_data), m_size); }
+		m_data = nullptr;
+		m_size = 0;
+		m_open_empty = false;
+	}
+#endif
+}
@@ -0,0 +1,38 @@
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <string>
+#include <cstddef>
+
+namespace SceneEditor {
+
+	// Read-only memory mapping of a whole file. The mapping is released when the
+	// object goes out of scope, so pointers into data() must not outlive it.
+	class MappedFile {
+	public:
+		MappedFile();
+		explicit MappedFile(const std::string& path);
+		~MappedFile();
+
+		bool open(const std::string& path);
+		void close();
+
+		bool isOpen() const { return m_data != nullptr || m_open_empty; }
+		const char* data() const { return m_data; }
+		size_t size() const { return m_size; }
+
+	private:
+		MappedFile(const MappedFile&);
+		MappedFile& operator=(const MappedFile&);
+
+		const char* m_data;
+		size_t m_size;
+		bool m_open_empty;
+#ifdef _WIN32
+		void* m_file;
+		void* m_mapping;
+#endif
+	};
+}
+
+#endif // __MAPPED_FILE_H__
@@ -0,0 +1,190 @@
+#include "MeshCacheClass.h"
+#include "MeshClass.h"
+
+#include <glm/common.hpp> // glm::min, glm::max
+#include <glm/gtc/type_ptr.hpp> // glm::make_mat4
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace SceneEditor {
+
+	namespace {
+
+		const char s_magic[8] = { 'D', 'Y', 'N', 'M', 'E', 'S', 'H', '\0' };
+		const uint32_t s_byte_order = 0x01020304;
+
+		size_t alignUp(size_t offset) {
+			return (offset + MeshCache::s_alignment - 1) & ~(MeshCache::s_alignment - 1);
+		}
+
+		// Section offsets are implied by the counts, so they can not disagree with them
+		void sectionOffsets(const MeshCacheHeader& header, size_t offsets[9]) {
+			offsets[0] = alignUp(sizeof(MeshCacheHeader));
+			offsets[1] = alignUp(offsets[0] + header.n_vertices * sizeof(glm::vec3));
+			offsets[2] = alignUp(offsets[1] + header.n_vertices * sizeof(glm::vec3));
+			offsets[3] = alignUp(offsets[2] + header.n_indices * sizeof(int));
+			offsets[4] = alignUp(offsets[3] + header.n_lod_indices * sizeof(int));
+			offsets[5] = alignUp(offsets[4] + header.n_lods * sizeof(MeshCacheLod));
+			offsets[6] = alignUp(offsets[5] + header.n_meshlets * sizeof(Meshlet));
+			offsets[7] = alignUp(offsets[6] + (size_t)header.n_vertices * header.vertex_stride);
+			offsets[8] = offsets[7] + ((size_t)header.n_indices + header.n_lod_indices) * header.index_bytes;
+		}
+
+		// The chain depends on the ratios, so a cache built with other ones is stale
+		uint32_t lodRatiosHash() {
+			const std::vector<float>& ratios = MeshSimplifier::s_lod_ratios;
+			uint64_t h = MeshCache::hash(reinterpret_cast<const char*>(ratios.data()), ratios.size() * sizeof(float));
+			return static_cast<uint32_t>(h ^ (h >> 32));
+		}
+	}
+
+	uint64_t MeshCache::hash(const char* data, size_t size) {
+		uint64_t h = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; ++i) {
+			h ^= static_cast<unsigned char>(data[i]);
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+	uint64_t MeshCache::hashFile(const std::string& path) {
+		MappedFile file(path);
+		if (!file.isOpen()) { return 0; }
+		return hash(file.data(), file.size());
+	}
+
+	std::string MeshCache::cachePath(const std::string& source_path) {
+		size_t dot = source_path.find_last_of('.');
+		size_t slash = source_path.find_last_of("/\\");
+		if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+			return source_path + ".meshcache";
+		}
+		return source_path.substr(0, dot) + ".meshcache";
+	}
+
+	bool MeshCache::load(const std::string& source_path, const VertexFormat& format) {
+		uint64_t source_hash = hashFile(source_path);
+		return source_hash != 0 && load(source_path, source_hash, format);
+	}
+
+	bool MeshCache::load(const std::string& source_path, uint64_t source_hash, const VertexFormat& format) {
+		m_header = nullptr;
+		if (!m_file.open(cachePath(source_path)) || m_file.size() < sizeof(MeshCacheHeader)) {
+			return false;
+		}
+		const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(m_file.data());
+		if (std::memcmp(header->magic, s_magic, sizeof(s_magic)) != 0
+			|| header->version != s_version
+			|| header->byte_order != s_byte_order
+			|| header->source_hash != source_hash
+			|| header->normal_weighting != (uint32_t)Mesh::s_normal_weighting
+			|| header->lod_ratios_hash != lodRatiosHash()
+			|| header->vertex_positions != (uint32_t)format.positions()
+			|| header->vertex_normals != (uint32_t)format.normals()
+			|| header->vertex_stride != (uint32_t)format.stride()
+			|| header->index_bytes != VertexFormat::indexBytes(header->n_vertices)) {
+			m_file.close();
+			return false;
+		}
+		size_t offsets[9];
+		sectionOffsets(*header, offsets);
+		if (offsets[8] > m_file.size()) {
+			m_file.close();
+			return false;
+		}
+		m_header = header;
+		m_positions = reinterpret_cast<const glm::vec3*>(m_file.data() + offsets[0]);
+		m_normals = reinterpret_cast<const glm::vec3*>(m_file.data() + offsets[1]);
+		m_indices = reinterpret_cast<const int*>(m_file.data() + offsets[2]);
+		m_lod_indices = reinterpret_cast<const int*>(m_file.data() + offsets[3]);
+		m_lods = reinterpret_cast<const MeshCacheLod*>(m_file.data() + offsets[4]);
+		m_meshlets = reinterpret_cast<const Meshlet*>(m_file.data() + offsets[5]);
+		m_vertex_stream = reinterpret_cast<const unsigned char*>(m_file.data() + offsets[6]);
+		m_index_stream = reinterpret_cast<const unsigned char*>(m_file.data() + offsets[7]);
+		return true;
+	}
+
+	glm::mat4 MeshCache::decode() const {
+		return glm::make_mat4(m_header->decode);
+	}
+
+	bool MeshCache::write(const std::string& source_path, uint64_t source_hash, const VertexFormat& format,
+		const std::vector<glm::vec3>& vertices,
+		const std::vector<glm::vec3>& normals,
+		const std::vector<int>& indices,
+		const std::vector<int>& lod_indices,
+		const std::vector<MeshLod>& lods,
+		const std::vector<Meshlet>& meshlets,
+		bool closed) {
+		if (vertices.size() != normals.size()) { return false; }
+
+		MeshCacheHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, s_magic, sizeof(s_magic));
+		header.version = s_version;
+		header.byte_order = s_byte_order;
+		header.source_hash = source_hash;
+		header.n_vertices = static_cast<uint32_t>(vertices.size());
+		header.n_indices = static_cast<uint32_t>(indices.size());
+		header.normal_weighting = static_cast<uint32_t>(Mesh::s_normal_weighting);
+		header.n_lod_indices = static_cast<uint32_t>(lod_indices.size());
+		header.n_lods = static_cast<uint32_t>(lods.size());
+		header.n_meshlets = static_cast<uint32_t>(meshlets.size());
+		header.closed = closed ? 1 : 0;
+		header.lod_ratios_hash = lodRatiosHash();
+		std::vector<unsigned char> vertex_stream, index_stream;
+		glm::mat4 decode;
+		format.encode(vertices.data(), normals.data(), vertices.size(), vertex_stream, decode);
+		VertexFormat::encodeIndices(indices.data(), indices.size(), lod_indices, vertices.size(), index_stream);
+		header.vertex_positions = static_cast<uint32_t>(format.positions());
+		header.vertex_normals = static_cast<uint32_t>(format.normals());
+		header.vertex_stride = static_cast<uint32_t>(format.stride());
+		header.index_bytes = static_cast<uint32_t>(VertexFormat::indexBytes(vertices.size()));
+		std::memcpy(header.decode, glm::value_ptr(decode), sizeof(header.decode));
+		glm::vec3 lo(std::numeric_limits<float>::max());
+		glm::vec3 hi(-std::numeric_limits<float>::max());
+		for (auto&& v : vertices) {
+			lo = glm::min(lo, v);
+			hi = glm::max(hi, v);
+		}
+		for (int k = 0; k < 3; ++k) {
+			header.bounds_min[k] = lo[k];
+			header.bounds_max[k] = hi[k];
+		}
+
+		size_t offsets[9];
+		sectionOffsets(header, offsets);
+		std::vector<char> blob(offsets[8], 0);
+		std::memcpy(blob.data(), &header, sizeof(header));
+		std::memcpy(blob.data() + offsets[0], vertices.data(), vertices.size() * sizeof(glm::vec3));
+		std::memcpy(blob.data() + offsets[1], normals.data(), normals.size() * sizeof(glm::vec3));
+		std::memcpy(blob.data() + offsets[2], indices.data(), indices.size() * sizeof(int));
+		std::memcpy(blob.data() + offsets[3], lod_indices.data(), lod_indices.size() * sizeof(int));
+		MeshCacheLod* cache_lods = reinterpret_cast<MeshCacheLod*>(blob.data() + offsets[4]);
+		for (size_t i = 0; i < lods.size(); ++i) {
+			cache_lods[i].first = static_cast<uint32_t>(lods[i].first);
+			cache_lods[i].count = static_cast<uint32_t>(lods[i].count);
+			cache_lods[i].error = lods[i].error;
+			cache_lods[i].first_meshlet = static_cast<uint32_t>(lods[i].first_meshlet);
+			cache_lods[i].meshlet_count = static_cast<uint32_t>(lods[i].meshlet_count);
+		}
+		std::memcpy(blob.data() + offsets[5], meshlets.data(), meshlets.size() * sizeof(Meshlet));
+		std::memcpy(blob.data() + offsets[6], vertex_stream.data(), vertex_stream.size());
+		std::memcpy(blob.data() + offsets[7], index_stream.data(), index_stream.size());
+
+		// write next to the target and rename, so a reader never maps a half-written file
+		std::string path = cachePath(source_path);
+		std::string tmp_path = path + ".tmp";
+		FILE* out = std::fopen(tmp_path.c_str(), "wb");
+		if (!out) { return false; }
+		bool ok = std::fwrite(blob.data(), 1, blob.size(), out) == blob.size();
+		ok = (std::fclose(out) == 0) && ok;
+		std::remove(path.c_str());
+		ok = ok && std::rename(tmp_path.c_str(), path.c_str()) == 0;
+		if (!ok) { std::remove(tmp_path.c_str()); }
+		return ok;
+	}
+}
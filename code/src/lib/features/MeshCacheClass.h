@@ -0,0 +1,120 @@
+#ifndef __MESH_CACHE_H__
+#define __MESH_CACHE_H__
+
+#include "MappedFileClass.h"
+#include "MeshSimplifierClass.h"
+#include "MeshletClass.h"
+#include "VertexFormatClass.h"
+
+#include <glm/vec3.hpp> // glm::vec3
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SceneEditor {
+
+	/* [MESH CACHE FORMAT]
+	* Header (160 bytes, fixed) followed by the position, normal, index, LOD
+	* index, LOD and meshlet sections, then the vertex and index streams
+	* already encoded for the GPU in the VertexFormat and index width named
+	* by the header. Every section starts on a 64 byte boundary so the mapped
+	* file can be handed to glBufferData as is. Positions are already
+	* unitized, the triangles already in MeshOptimizer order, and the LOD
+	* chain and meshlets are the ones the LOD stage built.
+	*/
+	struct MeshCacheHeader {
+		char magic[8];          // "DYNMESH\0"
+		uint32_t version;
+		uint32_t byte_order;    // 0x01020304 in the writer's byte order
+		uint64_t source_hash;   // FNV-1a of the source .off bytes
+		uint32_t n_vertices;
+		uint32_t n_indices;
+		float bounds_min[3];
+		float bounds_max[3];
+		uint32_t normal_weighting;  // Mesh::NormalWeighting the normals were built with
+		uint32_t n_lod_indices;     // coarser levels only; lods[0] is the index section
+		uint32_t n_lods;
+		uint32_t n_meshlets;
+		uint32_t closed;            // Meshlets::closed of the full mesh
+		uint32_t lod_ratios_hash;   // MeshSimplifier::s_lod_ratios the LOD chain was built with
+		uint32_t vertex_positions;  // VertexFormat of the vertex stream
+		uint32_t vertex_normals;
+		uint32_t vertex_stride;
+		uint32_t index_bytes;       // 2 or 4, width of the index stream
+		float decode[16];           // stored positions -> mesh space, column major
+	};
+	static_assert(sizeof(MeshCacheHeader) == 160, "MeshCacheHeader is an on-disk format of 160 bytes");
+
+	// MeshLod with fixed width fields
+	struct MeshCacheLod {
+		uint32_t first;
+		uint32_t count;
+		float error;
+		uint32_t first_meshlet;
+		uint32_t meshlet_count;
+	};
+	static_assert(sizeof(MeshCacheLod) == 20, "MeshCacheLod is an on-disk format of 20 bytes");
+	static_assert(sizeof(Meshlet) == 40, "Meshlet is stored as is and must stay 40 bytes");
+
+	class MeshCache {
+	public:
+		// 2: optimized draw order, 3: cleaned up, 4: weighted normals, 5: LOD chain and meshlets,
+		// 6: LOD ratios, 7: encoded vertex and index streams
+		static const uint32_t s_version = 7;
+		static const size_t s_alignment = 64;
+
+		// 64-bit FNV-1a of a byte range
+		static uint64_t hash(const char* data, size_t size);
+		// Hash of the file contents, 0 if it can not be read
+		static uint64_t hashFile(const std::string& path);
+		// data/bunny.off -> data/bunny.meshcache
+		static std::string cachePath(const std::string& source_path);
+
+		// Maps the cache next to source_path; fails if missing, stale, corrupt or
+		// encoded in another format
+		bool load(const std::string& source_path, const VertexFormat& format);
+		bool load(const std::string& source_path, uint64_t source_hash, const VertexFormat& format);
+		static bool write(const std::string& source_path, uint64_t source_hash, const VertexFormat& format,
+			const std::vector<glm::vec3>& vertices,
+			const std::vector<glm::vec3>& normals,
+			const std::vector<int>& indices,
+			const std::vector<int>& lod_indices,
+			const std::vector<MeshLod>& lods,
+			const std::vector<Meshlet>& meshlets,
+			bool closed);
+
+		const MeshCacheHeader& header() const { return *m_header; }
+		const glm::vec3* positions() const { return m_positions; }
+		const glm::vec3* normals() const { return m_normals; }
+		const int* indices() const { return m_indices; }
+		size_t vertexCount() const { return m_header->n_vertices; }
+		size_t indexCount() const { return m_header->n_indices; }
+		const int* lodIndices() const { return m_lod_indices; }
+		size_t lodIndexCount() const { return m_header->n_lod_indices; }
+		const MeshCacheLod* lods() const { return m_lods; }
+		size_t lodCount() const { return m_header->n_lods; }
+		const Meshlet* meshlets() const { return m_meshlets; }
+		size_t meshletCount() const { return m_header->n_meshlets; }
+		bool closed() const { return m_header->closed != 0; }
+		// Every level, ready for the vertex and element buffers
+		const unsigned char* vertexStream() const { return m_vertex_stream; }
+		const unsigned char* indexStream() const { return m_index_stream; }
+		size_t indexBytes() const { return m_header->index_bytes; }
+		glm::mat4 decode() const;
+
+	private:
+		MappedFile m_file;
+		const MeshCacheHeader* m_header = nullptr;
+		const glm::vec3* m_positions = nullptr;
+		const glm::vec3* m_normals = nullptr;
+		const int* m_indices = nullptr;
+		const int* m_lod_indices = nullptr;
+		const MeshCacheLod* m_lods = nullptr;
+		const Meshlet* m_meshlets = nullptr;
+		const unsigned char* m_vertex_stream = nullptr;
+		const unsigned char* m_index_stream = nullptr;
+	};
+}
+
+#endif // __MESH_CACHE_H__
@@ -0,0 +1,693 @@
+#include "MeshClass.h"
+#include "MappedFileClass.h"
+
+#include <glm/glm.hpp> // glm::cross, glm::dot, glm::length, glm::clamp, glm::floor
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_NORMALS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace SceneEditor {
+
+	namespace {
+
+		// chunks smaller than this are not worth a thread of their own
+		const size_t s_min_chunk_bytes = 1 << 20;
+		const size_t s_min_chunk_items = 1 << 14;
+		// welding grid resolution per axis; the key packs 21 bits of each
+		const float s_max_cells = float(1 << 20);
+
+		inline bool isBlank(char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		inline bool isDigit(char c) {
+			return c >= '0' && c <= '9';
+		}
+
+		inline const char* skipBlank(const char* p, const char* end) {
+			while (p < end && isBlank(*p)) { ++p; }
+			return p;
+		}
+
+		inline const char* nextLine(const char* p, const char* end) {
+			const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			return nl ? nl + 1 : end;
+		}
+
+		// A record line holds anything but whitespace or a '#' comment
+		inline bool isRecord(const char* p, const char* end) {
+			p = skipBlank(p, end);
+			return p < end && *p != '\n' && *p != '#';
+		}
+
+		// Locale-independent integer parse; returns nullptr when no number is found
+		const char* parseInt(const char* p, const char* end, int& out) {
+			p = skipBlank(p, end);
+			bool neg = false;
+			if (p < end && (*p == '-' || *p == '+')) {
+				neg = *p == '-';
+				++p;
+			}
+			if (p == end || !isDigit(*p)) { return nullptr; }
+			long long value = 0;
+			while (p < end && isDigit(*p)) {
+				value = value * 10 + (*p - '0');
+				++p;
+			}
+			out = static_cast<int>(neg ? -value : value);
+			return p;
+		}
+
+		// Locale-independent float parse in the spirit of std::from_chars
+		const char* parseFloat(const char* p, const char* end, float& out) {
+			static const double pow10[] = {
+				1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+			};
+			p = skipBlank(p, end);
+			bool neg = false;
+			if (p < end && (*p == '-' || *p == '+')) {
+				neg = *p == '-';
+				++p;
+			}
+			uint64_t mantissa = 0;
+			int digits = 0;
+			int exponent = 0;
+			bool any = false;
+			for (; p < end && isDigit(*p); ++p) {
+				any = true;
+				if (digits < 19) {
+					mantissa = mantissa * 10 + (*p - '0');
+					if (mantissa != 0) { ++digits; }
+				}
+				else {
+					++exponent;
+				}
+			}
+			if (p < end && *p == '.') {
+				for (++p; p < end && isDigit(*p); ++p) {
+					any = true;
+					if (digits < 19) {
+						mantissa = mantissa * 10 + (*p - '0');
+						if (mantissa != 0) { ++digits; }
+						--exponent;
+					}
+				}
+			}
+			if (!any) { return nullptr; }
+			if (p < end && (*p == 'e' || *p == 'E')) {
+				int e = 0;
+				const char* q = parseInt(p + 1, end, e);
+				if (q) {
+					exponent += e;
+					p = q;
+				}
+			}
+			double value = static_cast<double>(mantissa);
+			if (exponent < 0) {
+				value = -exponent <= 22 ? value / pow10[-exponent] : value * std::pow(10.0, exponent);
+			}
+			else if (exponent > 0) {
+				value = exponent <= 22 ? value * pow10[exponent] : value * std::pow(10.0, exponent);
+			}
+			out = static_cast<float>(neg ? -value : value);
+			return p;
+		}
+
+		// Skips whitespace, newlines and comments between header tokens
+		const char* skipHeaderSpace(const char* p, const char* end) {
+			while (p < end) {
+				if (isBlank(*p) || *p == '\n') { ++p; }
+				else if (*p == '#') { p = nextLine(p, end); }
+				else { break; }
+			}
+			return p;
+		}
+
+		// Runs fn(0..n-1), chunk 0 on the calling thread
+		template<typename F>
+		void parallelFor(size_t n, F fn) {
+			std::vector<std::thread> workers;
+			workers.reserve(n > 0 ? n - 1 : 0);
+			for (size_t i = 1; i < n; ++i) {
+				workers.emplace_back(fn, i);
+			}
+			if (n > 0) { fn(0); }
+			for (auto&& worker : workers) {
+				worker.join();
+			}
+		}
+
+		// Runs fn(begin, end) over [0, n) split in chunks of at least s_min_chunk_items
+		template<typename F>
+		void parallelRange(size_t n, F fn) {
+			size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+			size_t n_chunks = std::min(n_threads, n / s_min_chunk_items + 1);
+			parallelFor(n_chunks, [&](size_t c) {
+				fn(n * c / n_chunks, n * (c + 1) / n_chunks);
+			});
+		}
+
+		inline uint64_t cellKey(int x, int y, int z) {
+			return ((uint64_t)(x & 0x1fffff) << 42) | ((uint64_t)(y & 0x1fffff) << 21) | (uint64_t)(z & 0x1fffff);
+		}
+
+		inline float cornerAngle(const glm::vec3& u, const glm::vec3& v) {
+			float d = glm::length(u) * glm::length(v);
+			return d > 0.f ? std::acos(glm::clamp(glm::dot(u, v) / d, -1.f, 1.f)) : 0.f;
+		}
+
+		// Unit normal of abc and the weight of each of its corners
+		inline void faceNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
+			Mesh::NormalWeighting weighting, glm::vec3& normal, float* weights) {
+			glm::vec3 n = glm::cross(b - a, c - b);
+			float length = glm::length(n);
+			normal = length > 0.f ? n / length : glm::vec3(0.f);
+			if (weighting == Mesh::ANGLE_WEIGHTS) {
+				weights[0] = cornerAngle(b - a, c - a);
+				weights[1] = cornerAngle(c - b, a - b);
+				weights[2] = cornerAngle(a - c, b - c);
+			}
+			else {
+				weights[0] = weights[1] = weights[2] = weighting == Mesh::AREA_WEIGHTS ? length : 1.f;
+			}
+		}
+
+#ifdef MESH_NORMALS_SSE
+		inline __m128 length4(__m128 x, __m128 y, __m128 z) {
+			return _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		}
+
+		// 1 / x, 0 where x is 0
+		inline __m128 safeInverse4(__m128 x) {
+			return _mm_and_ps(_mm_cmpgt_ps(x, _mm_setzero_ps()), _mm_div_ps(_mm_set1_ps(1.f), x));
+		}
+
+		// cosine of the angle between u and v, clamped; 1 when either is zero
+		inline __m128 cornerCos4(__m128 ux, __m128 uy, __m128 uz, __m128 vx, __m128 vy, __m128 vz, __m128 inv_lu, __m128 inv_lv) {
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ux, vx), _mm_mul_ps(uy, vy)), _mm_mul_ps(uz, vz));
+			__m128 inv = _mm_mul_ps(inv_lu, inv_lv);
+			__m128 valid = _mm_cmpgt_ps(inv, _mm_setzero_ps());
+			__m128 cos = _mm_mul_ps(d, inv);
+			cos = _mm_or_ps(_mm_and_ps(valid, cos), _mm_andnot_ps(valid, _mm_set1_ps(1.f)));
+			return _mm_min_ps(_mm_max_ps(cos, _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+		}
+#endif
+
+		// faceNormal() for triangles [begin, end); four at a time where SSE is available.
+		// Without weights (uniform or area only) normals get the weight folded in.
+		void faceNormals(const glm::vec3* vertices, const int* indices, size_t begin, size_t end,
+			Mesh::NormalWeighting weighting, glm::vec3* normals, float* weights) {
+			size_t t = begin;
+#ifdef MESH_NORMALS_SSE
+			for (; t + 4 <= end; t += 4) {
+				const int* i = indices + t * 3;
+				const glm::vec3 *a0 = &vertices[i[0]], *b0 = &vertices[i[1]], *c0 = &vertices[i[2]];
+				const glm::vec3 *a1 = &vertices[i[3]], *b1 = &vertices[i[4]], *c1 = &vertices[i[5]];
+				const glm::vec3 *a2 = &vertices[i[6]], *b2 = &vertices[i[7]], *c2 = &vertices[i[8]];
+				const glm::vec3 *a3 = &vertices[i[9]], *b3 = &vertices[i[10]], *c3 = &vertices[i[11]];
+				__m128 ax = _mm_setr_ps(a0->x, a1->x, a2->x, a3->x);
+				__m128 ay = _mm_setr_ps(a0->y, a1->y, a2->y, a3->y);
+				__m128 az = _mm_setr_ps(a0->z, a1->z, a2->z, a3->z);
+				__m128 bx = _mm_setr_ps(b0->x, b1->x, b2->x, b3->x);
+				__m128 by = _mm_setr_ps(b0->y, b1->y, b2->y, b3->y);
+				__m128 bz = _mm_setr_ps(b0->z, b1->z, b2->z, b3->z);
+				__m128 cx = _mm_setr_ps(c0->x, c1->x, c2->x, c3->x);
+				__m128 cy = _mm_setr_ps(c0->y, c1->y, c2->y, c3->y);
+				__m128 cz = _mm_setr_ps(c0->z, c1->z, c2->z, c3->z);
+
+				// edges ab, bc, ca
+				__m128 e0x = _mm_sub_ps(bx, ax), e0y = _mm_sub_ps(by, ay), e0z = _mm_sub_ps(bz, az);
+				__m128 e1x = _mm_sub_ps(cx, bx), e1y = _mm_sub_ps(cy, by), e1z = _mm_sub_ps(cz, bz);
+				__m128 e2x = _mm_sub_ps(ax, cx), e2y = _mm_sub_ps(ay, cy), e2z = _mm_sub_ps(az, cz);
+				__m128 nx = _mm_sub_ps(_mm_mul_ps(e0y, e1z), _mm_mul_ps(e0z, e1y));
+				__m128 ny = _mm_sub_ps(_mm_mul_ps(e0z, e1x), _mm_mul_ps(e0x, e1z));
+				__m128 nz = _mm_sub_ps(_mm_mul_ps(e0x, e1y), _mm_mul_ps(e0y, e1x));
+				__m128 length = length4(nx, ny, nz);
+				__m128 inv = safeInverse4(length);
+				nx = _mm_mul_ps(nx, inv);
+				ny = _mm_mul_ps(ny, inv);
+				nz = _mm_mul_ps(nz, inv);
+
+				float out[3][4];
+				float w[3][4];
+				if (!weights) {
+					// the area weighted normal is the cross product itself
+					__m128 scale = weighting == Mesh::AREA_WEIGHTS ? length : _mm_set1_ps(1.f);
+					_mm_storeu_ps(out[0], _mm_mul_ps(nx, scale));
+					_mm_storeu_ps(out[1], _mm_mul_ps(ny, scale));
+					_mm_storeu_ps(out[2], _mm_mul_ps(nz, scale));
+					for (int k = 0; k < 4; ++k) {
+						normals[t + k] = glm::vec3(out[0][k], out[1][k], out[2][k]);
+					}
+					continue;
+				}
+				_mm_storeu_ps(out[0], nx);
+				_mm_storeu_ps(out[1], ny);
+				_mm_storeu_ps(out[2], nz);
+				if (weighting == Mesh::ANGLE_WEIGHTS) {
+					__m128 inv0 = safeInverse4(length4(e0x, e0y, e0z));
+					__m128 inv1 = safeInverse4(length4(e1x, e1y, e1z));
+					__m128 inv2 = safeInverse4(length4(e2x, e2y, e2z));
+					__m128 zero = _mm_setzero_ps();
+					// corner a sits between ab and -ca, b between bc and -ab, c between ca and -bc
+					_mm_storeu_ps(w[0], cornerCos4(e0x, e0y, e0z, _mm_sub_ps(zero, e2x), _mm_sub_ps(zero, e2y), _mm_sub_ps(zero, e2z), inv0, inv2));
+					_mm_storeu_ps(w[1], cornerCos4(e1x, e1y, e1z, _mm_sub_ps(zero, e0x), _mm_sub_ps(zero, e0y), _mm_sub_ps(zero, e0z), inv1, inv0));
+					_mm_storeu_ps(w[2], cornerCos4(e2x, e2y, e2z, _mm_sub_ps(zero, e1x), _mm_sub_ps(zero, e1y), _mm_sub_ps(zero, e1z), inv2, inv1));
+					for (int c = 0; c < 3; ++c) {
+						for (int k = 0; k < 4; ++k) {
+							w[c][k] = std::acos(w[c][k]);
+						}
+					}
+				}
+				else {
+					__m128 weight = weighting == Mesh::AREA_WEIGHTS ? length : _mm_set1_ps(1.f);
+					_mm_storeu_ps(w[0], weight);
+					_mm_storeu_ps(w[1], weight);
+					_mm_storeu_ps(w[2], weight);
+				}
+				for (int k = 0; k < 4; ++k) {
+					normals[t + k] = glm::vec3(out[0][k], out[1][k], out[2][k]);
+					for (int c = 0; c < 3; ++c) {
+						weights[(t + k) * 3 + c] = w[c][k];
+					}
+				}
+			}
+#endif
+			for (; t < end; ++t) {
+				const int* i = indices + t * 3;
+				float w[3];
+				faceNormal(vertices[i[0]], vertices[i[1]], vertices[i[2]], weighting, normals[t], weights ? weights + t * 3 : w);
+				if (!weights) { normals[t] *= w[0]; }
+			}
+		}
+
+		// Welding grid: cell key -> [begin, end) of the cell's vertices, linear probing
+		struct CellTable {
+			struct Entry {
+				uint64_t key;
+				uint32_t begin;
+				uint32_t end;
+			};
+			static const uint64_t s_empty = ~0ull;  // cellKey never sets the top bit
+
+			explicit CellTable(size_t n_cells) {
+				size_t size = 16;
+				while (size < 2 * n_cells) { size <<= 1; }
+				entries.assign(size, Entry{ s_empty, 0, 0 });
+				mask = size - 1;
+			}
+
+			static size_t hash(uint64_t key) {
+				return (size_t)((key * 0x9e3779b97f4a7c15ull) >> 29);
+			}
+
+			void insert(uint64_t key, uint32_t begin, uint32_t end) {
+				size_t i = hash(key) & mask;
+				while (entries[i].key != s_empty) { i = (i + 1) & mask; }
+				entries[i] = Entry{ key, begin, end };
+			}
+
+			const Entry* find(uint64_t key) const {
+				for (size_t i = hash(key) & mask; entries[i].key != s_empty; i = (i + 1) & mask) {
+					if (entries[i].key == key) { return &entries[i]; }
+				}
+				return nullptr;
+			}
+
+			std::vector<Entry> entries;
+			size_t mask;
+		};
+	}
+
+	size_t Mesh::read(const std::string& path,
+		std::vector<glm::vec3>& vertices, std::vector<int>& indices) {
+		MappedFile file(path);
+		ASSERT(file.isOpen(), std::string("Mesh file not exists: ") + path);
+		read(file.data(), file.data() + file.size(), vertices, indices);
+		return file.size();
+	}
+
+	void Mesh::read(const char* begin, const char* end,
+		std::vector<glm::vec3>& vertices, std::vector<int>& indices) {
+		// [HEADER] "OFF" followed by vertex, face and edge counts
+		const char* p = skipHeaderSpace(begin, end);
+		ASSERT(end - p >= 3 && std::strncmp(p, "OFF", 3) == 0, "Mesh::read: missing OFF header");
+		p += 3;
+		int counts[3];
+		for (int i = 0; i < 3; ++i) {
+			p = skipHeaderSpace(p, end);
+			p = parseInt(p, end, counts[i]);
+			ASSERT(p != nullptr && counts[i] >= 0, "Mesh::read: invalid OFF counts");
+		}
+		const char* body = nextLine(p, end);
+		const size_t n_vertex = counts[0];
+		const size_t n_face = counts[1];
+
+		vertices.resize(n_vertex);
+		indices.resize(n_face * 3);
+
+		// [CHUNKS] byte ranges of the body, each starting on a line boundary
+		size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+		size_t n_chunks = std::min(n_threads, static_cast<size_t>(end - body) / s_min_chunk_bytes + 1);
+		std::vector<const char*> bounds(n_chunks + 1, end);
+		bounds[0] = body;
+		for (size_t i = 1; i < n_chunks; ++i) {
+			const char* guess = body + (end - body) * i / n_chunks;
+			bounds[i] = std::max(bounds[i - 1], nextLine(guess, end));
+		}
+
+		// [PASS 1] count the records of each chunk to get its first record index
+		std::vector<size_t> first(n_chunks + 1, 0);
+		parallelFor(n_chunks, [&](size_t c) {
+			size_t n = 0;
+			for (const char* q = bounds[c]; q < bounds[c + 1]; ) {
+				const char* line_end = nextLine(q, bounds[c + 1]);
+				if (isRecord(q, line_end)) { ++n; }
+				q = line_end;
+			}
+			first[c + 1] = n;
+		});
+		for (size_t c = 0; c < n_chunks; ++c) {
+			first[c + 1] += first[c];
+		}
+		ASSERT(first[n_chunks] >= n_vertex + n_face, "Mesh::read: truncated OFF file");
+
+		// [PASS 2] parse each chunk directly into its slice of the output
+		std::vector<const char*> errors(n_chunks, nullptr);
+		parallelFor(n_chunks, [&](size_t c) {
+			const char* chunk_end = bounds[c + 1];
+			size_t record = first[c];
+			for (const char* line = bounds[c]; line < chunk_end && record < n_vertex + n_face; ) {
+				const char* line_end = nextLine(line, chunk_end);
+				const char* q = line;
+				line = line_end;
+				if (!isRecord(q, line_end)) { continue; }
+				if (record < n_vertex) {
+					glm::vec3& v = vertices[record];
+					for (int k = 0; k < 3 && q; ++k) {
+						q = parseFloat(q, line_end, v[k]);
+					}
+					if (!q) {
+						errors[c] = "Mesh::read: invalid vertex";
+						return;
+					}
+				}
+				else {
+					size_t face = record - n_vertex;
+					int n = 0;
+					q = parseInt(q, line_end, n);
+					if (!q || n != 3) {
+						errors[c] = "Mesh::read: only triangle faces are supported";
+						return;
+					}
+					for (int k = 0; k < 3 && q; ++k) {
+						int index = 0;
+						q = parseInt(q, line_end, index);
+						if (q && (index < 0 || static_cast<size_t>(index) >= n_vertex)) {
+							q = nullptr;
+						}
+						indices[3 * face + k] = index;
+					}
+					if (!q) {
+						errors[c] = "Mesh::read: invalid face index";
+						return;
+					}
+				}
+				++record;
+			}
+		});
+		for (auto&& error : errors) {
+			ASSERT(error == nullptr, error);
+		}
+	}
+
+	Mesh::NormalWeighting Mesh::s_normal_weighting = Mesh::AREA_WEIGHTS;
+
+	void Mesh::VertexCorners::build(const std::vector<int>& indices, size_t n_vertices) {
+		first.assign(n_vertices + 1, 0);
+		for (auto&& i : indices) {
+			++first[i + 1];
+		}
+		for (size_t v = 0; v < n_vertices; ++v) {
+			first[v + 1] += first[v];
+		}
+		corners.resize(indices.size());
+		std::vector<int> fill(first.begin(), first.end() - 1);
+		for (size_t k = 0; k < indices.size(); ++k) {
+			corners[fill[indices[k]]++] = (int)k;
+		}
+	}
+
+	void Mesh::computeNormals(const std::vector<glm::vec3>& vertices,
+		const std::vector<int>& indices, std::vector<glm::vec3>& normals, NormalWeighting weighting) {
+		const size_t n_vertices = vertices.size();
+		const size_t n_triangles = indices.size() / 3;
+
+		// [FACES] weighted normal per face; angles differ per corner and get their own weights
+		const bool by_corner = weighting == ANGLE_WEIGHTS;
+		std::vector<glm::vec3> face_normals(n_triangles);
+		std::vector<float> corner_weights(by_corner ? n_triangles * 3 : 0);
+		parallelRange(n_triangles, [&](size_t begin, size_t end) {
+			faceNormals(vertices.data(), indices.data(), begin, end, weighting,
+				face_normals.data(), by_corner ? corner_weights.data() : nullptr);
+		});
+
+		// [GATHER] every chunk owns a vertex range and walks only the corners around its vertices
+		VertexCorners corners;
+		corners.build(indices, n_vertices);
+		normals.resize(n_vertices);
+		parallelRange(n_vertices, [&](size_t begin, size_t end) {
+			for (size_t v = begin; v < end; ++v) {
+				glm::vec3 n(0.f);
+				for (int k = corners.first[v]; k < corners.first[v + 1]; ++k) {
+					int corner = corners.corners[k];
+					n += by_corner ? corner_weights[corner] * face_normals[corner / 3] : face_normals[corner / 3];
+				}
+				float length = glm::length(n);
+				normals[v] = length > 0.f ? n / length : n;
+			}
+		});
+	}
+
+	void Mesh::updateNormals(const std::vector<glm::vec3>& vertices,
+		const std::vector<int>& indices, const VertexCorners& corners,
+		const std::vector<int>& edited, std::vector<glm::vec3>& normals, NormalWeighting weighting) {
+		// a moved vertex changes the faces around it, and with them every vertex of those faces
+		std::vector<int> touched;
+		std::vector<bool> seen(vertices.size(), false);
+		for (int v : edited) {
+			for (int k = corners.first[v]; k < corners.first[v + 1]; ++k) {
+				int t = corners.corners[k] / 3;
+				for (int c = 0; c < 3; ++c) {
+					int u = indices[t * 3 + c];
+					if (!seen[u]) {
+						seen[u] = true;
+						touched.push_back(u);
+					}
+				}
+			}
+			if (!seen[v]) {
+				seen[v] = true;
+				touched.push_back(v);
+			}
+		}
+
+		normals.resize(vertices.size());
+		parallelRange(touched.size(), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				int v = touched[i];
+				glm::vec3 n(0.f);
+				for (int k = corners.first[v]; k < corners.first[v + 1]; ++k) {
+					int corner = corners.corners[k];
+					const int* t = &indices[corner - corner % 3];
+					glm::vec3 face;
+					float weights[3];
+					faceNormal(vertices[t[0]], vertices[t[1]], vertices[t[2]], weighting, face, weights);
+					n += weights[corner % 3] * face;
+				}
+				float length = glm::length(n);
+				normals[v] = length > 0.f ? n / length : n;
+			}
+		});
+	}
+
+	void Mesh::unitize(std::vector<glm::vec3>& vertices) {
+		if (vertices.empty()) { return; }
+		glm::vec3 lo(std::numeric_limits<float>::max());
+		glm::vec3 hi(std::numeric_limits<float>::lowest());
+		for (auto&& v : vertices) {
+			lo = glm::min(lo, v);
+			hi = glm::max(hi, v);
+		}
+		glm::vec3 center = (lo + hi) / 2.f;
+		float scale = std::max({ hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] });
+		for (auto&& v : vertices) {
+			v -= center;
+			if (scale != 0.f) {
+				v /= scale;
+			}
+		}
+	}
+
+	Mesh::CleanStats Mesh::clean(std::vector<glm::vec3>& vertices, std::vector<int>& indices, float tolerance) {
+		auto t_start = std::chrono::high_resolution_clock::now();
+		CleanStats stats;
+		const size_t n_vertices = vertices.size();
+		stats.vertices_before = n_vertices;
+
+		// [WELD] cells at least twice the tolerance: a match lies in one of the 8 cells
+		// around the corner of the vertex's own cell that is nearest to it
+		glm::vec3 lo(std::numeric_limits<float>::max());
+		glm::vec3 hi(std::numeric_limits<float>::lowest());
+		for (auto&& v : vertices) {
+			lo = glm::min(lo, v);
+			hi = glm::max(hi, v);
+		}
+		float extent = n_vertices ? std::max({ hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] }) : 0.f;
+		float eps = tolerance * extent;
+		float cell = std::max(2.f * eps, extent / s_max_cells);
+		float inv_cell = cell > 0.f ? 1.f / cell : 1.f;
+
+		std::vector<uint64_t> keys(n_vertices);
+		parallelRange(n_vertices, [&](size_t begin, size_t end) {
+			for (size_t v = begin; v < end; ++v) {
+				glm::ivec3 c(glm::floor((vertices[v] - lo) * inv_cell));
+				keys[v] = cellKey(c.x, c.y, c.z);
+			}
+		});
+		std::vector<int> order(n_vertices);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](int a, int b) {
+			return keys[a] != keys[b] ? keys[a] < keys[b] : a < b;
+		});
+		// cell -> range of order (vertices ascending inside), open addressing
+		CellTable cells(n_vertices);
+		for (size_t i = 0; i < n_vertices; ) {
+			size_t j = i + 1;
+			while (j < n_vertices && keys[order[j]] == keys[order[i]]) { ++j; }
+			cells.insert(keys[order[i]], (uint32_t)i, (uint32_t)j);
+			i = j;
+		}
+
+		// each vertex points at the lowest vertex within eps of it...
+		std::vector<int> remap(n_vertices);
+		const float eps2 = eps * eps;
+		parallelRange(n_vertices, [&](size_t begin, size_t end) {
+			for (size_t v = begin; v < end; ++v) {
+				const glm::vec3& p = vertices[v];
+				glm::vec3 g = (p - lo) * inv_cell;
+				glm::ivec3 c(glm::floor(g));
+				glm::ivec3 side(g.x - c.x < 0.5f ? -1 : 1, g.y - c.y < 0.5f ? -1 : 1, g.z - c.z < 0.5f ? -1 : 1);
+				int best = (int)v;
+				for (int n = 0; n < 8; ++n) {
+					const CellTable::Entry* e = cells.find(cellKey(
+						c.x + (n & 1 ? side.x : 0), c.y + (n & 2 ? side.y : 0), c.z + (n & 4 ? side.z : 0)));
+					if (!e) { continue; }
+					for (uint32_t k = e->begin; k < e->end && order[k] < best; ++k) {
+						glm::vec3 d = vertices[order[k]] - p;
+						if (glm::dot(d, d) <= eps2) { best = order[k]; }
+					}
+				}
+				remap[v] = best;
+			}
+		});
+		// ...and chains collapse onto their root, which is always lower
+		for (size_t v = 0; v < n_vertices; ++v) {
+			remap[v] = remap[remap[v]];
+			if (remap[v] != (int)v) { ++stats.welded; }
+		}
+
+		// [TRIANGLES] degenerate after welding or of zero area
+		const size_t n_triangles = indices.size() / 3;
+		std::vector<char> keep(n_triangles, 0);
+		parallelRange(n_triangles, [&](size_t begin, size_t end) {
+			for (size_t t = begin; t < end; ++t) {
+				int a = remap[indices[t * 3]];
+				int b = remap[indices[t * 3 + 1]];
+				int c = remap[indices[t * 3 + 2]];
+				indices[t * 3] = a;
+				indices[t * 3 + 1] = b;
+				indices[t * 3 + 2] = c;
+				if (a == b || b == c || a == c) { continue; }
+				glm::vec3 n = glm::cross(vertices[b] - vertices[a], vertices[c] - vertices[a]);
+				keep[t] = glm::dot(n, n) > eps2 * eps2;
+			}
+		});
+
+		// [DUPLICATES] the same three vertices in any order; the first one stays
+		std::vector<int> faces;
+		faces.reserve(n_triangles);
+		for (size_t t = 0; t < n_triangles; ++t) {
+			if (keep[t]) { faces.push_back((int)t); }
+			else { ++stats.degenerate; }
+		}
+		std::vector<glm::ivec3> sorted(n_triangles);
+		parallelRange(faces.size(), [&](size_t begin, size_t end) {
+			for (size_t f = begin; f < end; ++f) {
+				const int* t = &indices[faces[f] * 3];
+				int a = std::min({ t[0], t[1], t[2] });
+				int c = std::max({ t[0], t[1], t[2] });
+				sorted[faces[f]] = glm::ivec3(a, t[0] + t[1] + t[2] - a - c, c);
+			}
+		});
+		std::sort(faces.begin(), faces.end(), [&](int a, int b) {
+			const glm::ivec3& p = sorted[a];
+			const glm::ivec3& q = sorted[b];
+			if (p.x != q.x) { return p.x < q.x; }
+			if (p.y != q.y) { return p.y < q.y; }
+			if (p.z != q.z) { return p.z < q.z; }
+			return a < b;
+		});
+		for (size_t f = 1; f < faces.size(); ++f) {
+			if (sorted[faces[f]] == sorted[faces[f - 1]]) {
+				keep[faces[f]] = 0;
+				++stats.duplicate;
+			}
+		}
+
+		size_t out = 0;
+		for (size_t t = 0; t < n_triangles; ++t) {
+			if (!keep[t]) { continue; }
+			indices[out++] = indices[t * 3];
+			indices[out++] = indices[t * 3 + 1];
+			indices[out++] = indices[t * 3 + 2];
+		}
+		indices.resize(out);
+
+		// [COMPACT] vertices no triangle uses, welded ones included
+		std::vector<int> compact(n_vertices, -1);
+		for (auto&& i : indices) {
+			compact[i] = 0;
+		}
+		size_t next = 0;
+		for (size_t v = 0; v < n_vertices; ++v) {
+			if (compact[v] < 0) { continue; }
+			compact[v] = (int)next;
+			vertices[next++] = vertices[v];
+		}
+		vertices.resize(next);
+		parallelRange(indices.size(), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				indices[i] = compact[indices[i]];
+			}
+		});
+
+		stats.vertices_after = next;
+		stats.unreferenced = n_vertices - next - stats.welded;
+		auto t_end = std::chrono::high_resolution_clock::now();
+		stats.ms = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+		return stats;
+	}
+}
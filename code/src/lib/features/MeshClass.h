@@ -5,35 +5,81 @@
 
 #include <glm/vec3.hpp> // glm::vec3
 
+#include <string>
 #include <vector>
-#include <fstream>
 
 namespace SceneEditor {
 
 	class Mesh {
 	public:
-		static std::pair<std::vector<glm::vec3>, std::vector<int>>
-			read(const std::string& path) {
-			std::ifstream infile(path, std::ifstream::binary);
-
-			std::string line;
-			std::getline(infile, line);
-
-			int n_vertex, n_face, n_edge, tmp;
-			infile >> n_vertex >> n_face >> n_edge;
-			std::vector<glm::vec3> vertices(n_vertex);
-			std::vector<int> indices(n_face * 3);
-			for (int i = 0; i < n_vertex; ++i) {
-				infile >> vertices[i][0] >> vertices[i][1] >> vertices[i][2];
-			}
-			for (int i = 0; i < n_face; ++i) {
-				infile >> tmp;
-				for (int j = 0; j < 3; ++j) {
-					infile >> indices[3 * i + j];
-				}
-			}
-			return { vertices, indices };
-		}
+		/* [OFF READER]
+		* Memory-maps the file and parses the vertex and face sections in
+		* parallel chunks split on line boundaries. The result is written in
+		* place into vertices/indices. Returns the number of bytes parsed.
+		*/
+		static size_t read(const std::string& path,
+			std::vector<glm::vec3>& vertices, std::vector<int>& indices);
+
+		// Same as read(path, ...) for an OFF file that is already in memory
+		static void read(const char* begin, const char* end,
+			std::vector<glm::vec3>& vertices, std::vector<int>& indices);
+
+		enum NormalWeighting {
+			UNIFORM_WEIGHTS = 0,  // every face around a vertex counts the same
+			AREA_WEIGHTS = 1,     // faces count by their area
+			ANGLE_WEIGHTS = 2     // faces count by their corner angle at the vertex
+		};
+
+		// Corners (3 * triangle + corner) around each vertex, compressed
+		struct VertexCorners {
+			std::vector<int> first;    // n_vertices + 1 offsets into corners
+			std::vector<int> corners;
+			void build(const std::vector<int>& indices, size_t n_vertices);
+		};
+
+		/* [NORMALS]
+		* Unit vertex normals from the weighted face normals around each
+		* vertex. Face normals are computed four at a time with SSE in parallel
+		* chunks. The sums are split by vertex range instead: the corners are
+		* first bucketed per vertex (VertexCorners), then each chunk walks only
+		* the corners of its own vertices, so nothing is shared.
+		*/
+		static void computeNormals(const std::vector<glm::vec3>& vertices,
+			const std::vector<int>& indices, std::vector<glm::vec3>& normals,
+			NormalWeighting weighting = s_normal_weighting);
+
+		// Recomputes the normals touched by moving the edited vertices (they and
+		// their neighbours); corners must match indices
+		static void updateNormals(const std::vector<glm::vec3>& vertices,
+			const std::vector<int>& indices, const VertexCorners& corners,
+			const std::vector<int>& edited, std::vector<glm::vec3>& normals,
+			NormalWeighting weighting = s_normal_weighting);
+
+		// Weighting used when none is given; set before the importer starts
+		static NormalWeighting s_normal_weighting;
+
+		// Centers the vertices on the origin and scales the longest side to 1
+		static void unitize(std::vector<glm::vec3>& vertices);
+
+		struct CleanStats {
+			size_t welded = 0;        // vertices merged into an earlier one
+			size_t degenerate = 0;    // triangles with a repeated vertex or zero area
+			size_t duplicate = 0;     // triangles over the same three vertices as an earlier one
+			size_t unreferenced = 0;  // other vertices no triangle used
+			size_t vertices_before = 0;
+			size_t vertices_after = 0;
+			double ms = 0.0;
+		};
+
+		/* [CLEANUP]
+		* Welds vertices closer than tolerance (relative to the longest side of
+		* the bounds) through a spatial hash, drops degenerate and duplicate
+		* triangles, then compacts away unreferenced vertices. Survivors keep
+		* their relative order; a welded group takes its lowest index. The
+		* per-vertex and per-triangle passes run in parallel chunks.
+		*/
+		static CleanStats clean(std::vector<glm::vec3>& vertices, std::vector<int>& indices,
+			float tolerance = 1e-6f);
 	};
 }
 
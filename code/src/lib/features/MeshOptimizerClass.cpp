@@ -0,0 +1,216 @@
+#include "MeshOptimizerClass.h"
+
+#include <glm/glm.hpp> // glm::cross, glm::dot, glm::length
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+namespace SceneEditor {
+
+	namespace {
+
+		// a cut only starts a new cluster once the current one has this many triangles;
+		// smaller clusters cost more cache misses at their seams than they save in overdraw
+		const size_t s_min_cluster = 64;
+	}
+
+	double MeshOptimizer::acmr(const std::vector<int>& indices, size_t n_vertices, int cache_size) {
+		size_t n_triangles = indices.size() / 3;
+		if (n_triangles == 0) { return 0.0; }
+		// FIFO: a vertex is in the cache while fewer than cache_size misses followed its own
+		std::vector<size_t> entered(n_vertices, 0);
+		size_t misses = 0;
+		for (size_t i = 0; i < n_triangles * 3; ++i) {
+			int v = indices[i];
+			if (entered[v] == 0 || misses - entered[v] >= (size_t)cache_size) {
+				++misses;
+				entered[v] = misses;
+			}
+		}
+		return (double)misses / (double)n_triangles;
+	}
+
+	void MeshOptimizer::tipsify(std::vector<int>& indices, size_t n_vertices, int cache_size,
+		std::vector<size_t>& clusters) {
+		clusters.clear();
+		size_t n_triangles = indices.size() / 3;
+		if (n_triangles == 0) { return; }
+
+		// vertex -> triangles, compressed
+		std::vector<int> live(n_vertices, 0);
+		for (size_t i = 0; i < n_triangles * 3; ++i) {
+			++live[indices[i]];
+		}
+		std::vector<size_t> first(n_vertices + 1, 0);
+		for (size_t v = 0; v < n_vertices; ++v) {
+			first[v + 1] = first[v] + live[v];
+		}
+		std::vector<int> adjacent(n_triangles * 3);
+		std::vector<size_t> fill(first.begin(), first.end() - 1);
+		for (size_t i = 0; i < n_triangles * 3; ++i) {
+			adjacent[fill[indices[i]]++] = (int)(i / 3);
+		}
+
+		std::vector<int> cache_time(n_vertices, 0);
+		std::vector<bool> emitted(n_triangles, false);
+		std::vector<int> dead_end;
+		std::vector<int> candidates;
+		std::vector<int> out;
+		out.reserve(n_triangles * 3);
+		int time = cache_size + 1;
+		size_t cursor = 0;
+		size_t cluster_start = 0;
+		bool cut = true;
+
+		int fanning = indices[0];
+		while (fanning >= 0) {
+			candidates.clear();
+			for (size_t k = first[fanning]; k < first[fanning + 1]; ++k) {
+				int t = adjacent[k];
+				if (emitted[t]) { continue; }
+				if (cut && (clusters.empty() || out.size() / 3 - cluster_start >= s_min_cluster)) {
+					cluster_start = out.size() / 3;
+					clusters.push_back(cluster_start);
+				}
+				cut = false;
+				for (int c = 0; c < 3; ++c) {
+					int v = indices[t * 3 + c];
+					out.push_back(v);
+					dead_end.push_back(v);
+					candidates.push_back(v);
+					--live[v];
+					if (time - cache_time[v] > cache_size) {
+						cache_time[v] = time;
+						++time;
+					}
+				}
+				emitted[t] = true;
+			}
+
+			// next fan: the candidate that is still in the cache after its own fan and is oldest
+			int next = -1;
+			int best = -1;
+			for (int v : candidates) {
+				if (live[v] <= 0) { continue; }
+				int priority = 0;
+				if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+					priority = time - cache_time[v];
+				}
+				if (priority > best) {
+					best = priority;
+					next = v;
+				}
+			}
+			if (next < 0) {
+				// dead end: a recent vertex with work left, else the next one in input order
+				while (!dead_end.empty() && next < 0) {
+					int v = dead_end.back();
+					dead_end.pop_back();
+					if (live[v] > 0) { next = v; }
+				}
+				while (next < 0 && cursor < n_vertices) {
+					if (live[cursor] > 0) { next = (int)cursor; }
+					++cursor;
+				}
+				// the cache is cold from here on
+				cut = next < 0 || time - cache_time[next] > cache_size;
+			}
+			fanning = next;
+		}
+		indices.swap(out);
+	}
+
+	void MeshOptimizer::orderClusters(const std::vector<glm::vec3>& vertices,
+		std::vector<int>& indices, const std::vector<size_t>& clusters) {
+		size_t n_triangles = indices.size() / 3;
+		size_t n_clusters = clusters.size();
+		if (n_clusters < 2) { return; }
+
+		std::vector<glm::vec3> centroid(n_clusters, glm::vec3(0.f));
+		std::vector<glm::vec3> normal(n_clusters, glm::vec3(0.f));
+		std::vector<float> area(n_clusters, 0.f);
+		glm::vec3 mesh_centroid(0.f);
+		float mesh_area = 0.f;
+		for (size_t c = 0; c < n_clusters; ++c) {
+			size_t end = c + 1 < n_clusters ? clusters[c + 1] : n_triangles;
+			for (size_t t = clusters[c]; t < end; ++t) {
+				const glm::vec3& a = vertices[indices[t * 3]];
+				const glm::vec3& b = vertices[indices[t * 3 + 1]];
+				const glm::vec3& d = vertices[indices[t * 3 + 2]];
+				// twice the area, pointing along the face normal
+				glm::vec3 n = glm::cross(b - a, d - b);
+				float w = glm::length(n);
+				centroid[c] += w * (a + b + d) / 3.f;
+				normal[c] += n;
+				area[c] += w;
+			}
+			mesh_centroid += centroid[c];
+			mesh_area += area[c];
+		}
+		if (mesh_area > 0.f) { mesh_centroid /= mesh_area; }
+
+		std::vector<float> key(n_clusters, 0.f);
+		for (size_t c = 0; c < n_clusters; ++c) {
+			float n = glm::length(normal[c]);
+			if (area[c] > 0.f && n > 0.f) {
+				key[c] = glm::dot(centroid[c] / area[c] - mesh_centroid, normal[c] / n);
+			}
+		}
+		std::vector<size_t> order(n_clusters);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return key[a] > key[b]; });
+
+		std::vector<int> out;
+		out.reserve(indices.size());
+		for (size_t c : order) {
+			size_t end = c + 1 < n_clusters ? clusters[c + 1] : n_triangles;
+			out.insert(out.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+		}
+		indices.swap(out);
+	}
+
+	void MeshOptimizer::reorderVertices(std::vector<glm::vec3>& vertices,
+		std::vector<glm::vec3>& normals, std::vector<int>& indices) {
+		size_t n = vertices.size();
+		std::vector<int> remap(n, -1);
+		int next = 0;
+		for (auto&& i : indices) {
+			if (remap[i] < 0) { remap[i] = next++; }
+			i = remap[i];
+		}
+		for (size_t v = 0; v < n; ++v) {
+			if (remap[v] < 0) { remap[v] = next++; }
+		}
+
+		std::vector<glm::vec3> moved(n);
+		for (size_t v = 0; v < n; ++v) {
+			moved[remap[v]] = vertices[v];
+		}
+		vertices.swap(moved);
+		if (normals.size() == n) {
+			for (size_t v = 0; v < n; ++v) {
+				moved[remap[v]] = normals[v];
+			}
+			normals.swap(moved);
+		}
+	}
+
+	MeshOptimizer::Stats MeshOptimizer::optimize(std::vector<glm::vec3>& vertices,
+		std::vector<glm::vec3>& normals, std::vector<int>& indices) {
+		auto t_start = std::chrono::high_resolution_clock::now();
+		Stats stats;
+		stats.acmr_before = acmr(indices, vertices.size());
+
+		std::vector<size_t> clusters;
+		tipsify(indices, vertices.size(), s_cache_size, clusters);
+		orderClusters(vertices, indices, clusters);
+		reorderVertices(vertices, normals, indices);
+
+		stats.acmr_after = acmr(indices, vertices.size());
+		stats.clusters = clusters.size();
+		auto t_end = std::chrono::high_resolution_clock::now();
+		stats.ms = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+		return stats;
+	}
+}
@@ -0,0 +1,295 @@
+#include "MeshSimplifierClass.h"
+#include "MeshOptimizerClass.h"
+
+#include <glm/glm.hpp> // glm::cross, glm::dot, glm::length
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace SceneEditor {
+
+	std::vector<float> MeshSimplifier::s_lod_ratios = { 0.5f, 0.25f, 0.1f };
+
+	namespace {
+
+		// boundary planes count this many times a face plane
+		const double s_boundary_weight = 10.0;
+		// a collapse may turn a face by up to ~75 degrees
+		const float s_min_normal_dot = 0.25f;
+
+		// Symmetric 4x4 error matrix: error(p) = p'Ap + 2b'p + c
+		struct Quadric {
+			double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+			double b0 = 0, b1 = 0, b2 = 0;
+			double c = 0;
+
+			// plane n.p + d = 0 with unit n
+			void addPlane(const glm::vec3& n, float d, double w) {
+				a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+				a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+				b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+				c += w * d * d;
+			}
+
+			void add(const Quadric& q) {
+				a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+				b0 += q.b0; b1 += q.b1; b2 += q.b2;
+				c += q.c;
+			}
+
+			double error(const glm::vec3& p) const {
+				double x = p.x, y = p.y, z = p.z;
+				double e = a00 * x * x + a11 * y * y + a22 * z * z
+					+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+					+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+				return std::max(e, 0.0);
+			}
+		};
+
+		struct Collapse {
+			double cost;
+			int from;
+			int to;
+			unsigned from_stamp;
+			unsigned to_stamp;
+			bool operator<(const Collapse& other) const { return cost > other.cost; }  // min-heap
+		};
+
+		class Simplifier {
+		public:
+			Simplifier(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices)
+				: m_vertices(vertices)
+				, m_indices(indices)
+				, m_quadrics(vertices.size())
+				, m_triangles(vertices.size())
+				, m_stamp(vertices.size(), 0)
+				, m_removed(vertices.size(), false)
+				, m_dead(indices.size() / 3, false)
+				, m_live(indices.size() / 3)
+				, m_error(0.0) {
+				size_t n_triangles = indices.size() / 3;
+				for (size_t t = 0; t < n_triangles; ++t) {
+					glm::vec3 n = normal((int)t);
+					float length = glm::length(n);
+					if (length > 0.f) { n /= length; }
+					for (int c = 0; c < 3; ++c) {
+						int v = m_indices[t * 3 + c];
+						m_quadrics[v].addPlane(n, -glm::dot(n, m_vertices[v]), 1.0);
+						m_triangles[v].push_back((int)t);
+					}
+				}
+				addBoundaries();
+				for (size_t t = 0; t < n_triangles; ++t) {
+					for (int c = 0; c < 3; ++c) {
+						int a = m_indices[t * 3 + c];
+						int b = m_indices[t * 3 + (c + 1) % 3];
+						if (a < b) { push(a, b); }
+					}
+				}
+			}
+
+			size_t live() const { return m_live; }
+			double error() const { return m_error; }
+
+			// Collapses edges, cheapest first, until at most target triangles are left
+			void reduce(size_t target) {
+				while (m_live > target && !m_heap.empty()) {
+					Collapse collapse = m_heap.top();
+					m_heap.pop();
+					if (m_removed[collapse.from] || m_removed[collapse.to]
+						|| m_stamp[collapse.from] != collapse.from_stamp || m_stamp[collapse.to] != collapse.to_stamp) {
+						continue;
+					}
+					if (!allowed(collapse.from, collapse.to)) { continue; }
+					apply(collapse.from, collapse.to);
+					m_error = std::max(m_error, collapse.cost);
+				}
+			}
+
+			// Live triangles in input order
+			void emit(std::vector<int>& out) const {
+				out.clear();
+				for (size_t t = 0; t < m_dead.size(); ++t) {
+					if (m_dead[t]) { continue; }
+					out.insert(out.end(), m_indices.begin() + t * 3, m_indices.begin() + t * 3 + 3);
+				}
+			}
+
+		private:
+			glm::vec3 normal(int t) const {
+				const glm::vec3& a = m_vertices[m_indices[t * 3]];
+				const glm::vec3& b = m_vertices[m_indices[t * 3 + 1]];
+				const glm::vec3& c = m_vertices[m_indices[t * 3 + 2]];
+				return glm::cross(b - a, c - b);
+			}
+
+			// Planes through each open edge, perpendicular to its face
+			void addBoundaries() {
+				struct Edge {
+					int a, b, t;
+					bool operator<(const Edge& o) const { return a != o.a ? a < o.a : b < o.b; }
+				};
+				std::vector<Edge> edges;
+				edges.reserve(m_indices.size());
+				for (size_t t = 0; t < m_indices.size() / 3; ++t) {
+					for (int c = 0; c < 3; ++c) {
+						int a = m_indices[t * 3 + c];
+						int b = m_indices[t * 3 + (c + 1) % 3];
+						edges.push_back(Edge{ std::min(a, b), std::max(a, b), (int)t });
+					}
+				}
+				std::sort(edges.begin(), edges.end());
+				for (size_t i = 0; i < edges.size(); ) {
+					size_t j = i + 1;
+					while (j < edges.size() && edges[j].a == edges[i].a && edges[j].b == edges[i].b) { ++j; }
+					if (j - i == 1) {
+						const glm::vec3& p = m_vertices[edges[i].a];
+						const glm::vec3& q = m_vertices[edges[i].b];
+						glm::vec3 n = glm::cross(q - p, normal(edges[i].t));
+						float length = glm::length(n);
+						if (length > 0.f) {
+							n /= length;
+							m_quadrics[edges[i].a].addPlane(n, -glm::dot(n, p), s_boundary_weight);
+							m_quadrics[edges[i].b].addPlane(n, -glm::dot(n, p), s_boundary_weight);
+						}
+					}
+					i = j;
+				}
+			}
+
+			// Queues the cheaper direction of edge ab
+			void push(int a, int b) {
+				Quadric q = m_quadrics[a];
+				q.add(m_quadrics[b]);
+				double to_b = q.error(m_vertices[b]);
+				double to_a = q.error(m_vertices[a]);
+				if (to_b <= to_a) {
+					m_heap.push(Collapse{ to_b, a, b, m_stamp[a], m_stamp[b] });
+				}
+				else {
+					m_heap.push(Collapse{ to_a, b, a, m_stamp[b], m_stamp[a] });
+				}
+			}
+
+			void neighbours(int v, std::vector<int>& out) const {
+				out.clear();
+				for (int t : m_triangles[v]) {
+					if (m_dead[t]) { continue; }
+					for (int c = 0; c < 3; ++c) {
+						int u = m_indices[t * 3 + c];
+						if (u != v) { out.push_back(u); }
+					}
+				}
+				std::sort(out.begin(), out.end());
+				out.erase(std::unique(out.begin(), out.end()), out.end());
+			}
+
+			bool contains(int t, int v) const {
+				return m_indices[t * 3] == v || m_indices[t * 3 + 1] == v || m_indices[t * 3 + 2] == v;
+			}
+
+			bool allowed(int from, int to) {
+				// link condition: the only shared neighbours are the tips of the shared faces
+				size_t shared_faces = 0;
+				for (int t : m_triangles[from]) {
+					if (!m_dead[t] && contains(t, to)) { ++shared_faces; }
+				}
+				if (shared_faces == 0) { return false; }
+				neighbours(from, m_from_ring);
+				neighbours(to, m_to_ring);
+				size_t shared = 0;
+				for (size_t i = 0, j = 0; i < m_from_ring.size() && j < m_to_ring.size(); ) {
+					if (m_from_ring[i] < m_to_ring[j]) { ++i; }
+					else if (m_from_ring[i] > m_to_ring[j]) { ++j; }
+					else { ++shared; ++i; ++j; }
+				}
+				if (shared != shared_faces) { return false; }
+
+				// faces that stay must not fold over
+				for (int t : m_triangles[from]) {
+					if (m_dead[t] || contains(t, to)) { continue; }
+					glm::vec3 p[3];
+					for (int c = 0; c < 3; ++c) {
+						int v = m_indices[t * 3 + c];
+						p[c] = m_vertices[v == from ? to : v];
+					}
+					glm::vec3 before = normal(t);
+					glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[1]);
+					float lengths = glm::length(before) * glm::length(after);
+					if (lengths <= 0.f || glm::dot(before, after) < s_min_normal_dot * lengths) { return false; }
+				}
+				return true;
+			}
+
+			void apply(int from, int to) {
+				for (int t : m_triangles[from]) {
+					if (m_dead[t]) { continue; }
+					if (contains(t, to)) {
+						m_dead[t] = true;
+						--m_live;
+						continue;
+					}
+					for (int c = 0; c < 3; ++c) {
+						if (m_indices[t * 3 + c] == from) { m_indices[t * 3 + c] = to; }
+					}
+					m_triangles[to].push_back(t);
+				}
+				m_triangles[from].clear();
+				m_removed[from] = true;
+				m_quadrics[to].add(m_quadrics[from]);
+				++m_stamp[to];
+				neighbours(to, m_to_ring);
+				for (int v : m_to_ring) {
+					push(to, v);
+				}
+			}
+
+		private:
+			const std::vector<glm::vec3>& m_vertices;
+			std::vector<int> m_indices;
+			std::vector<Quadric> m_quadrics;
+			std::vector<std::vector<int>> m_triangles;  // per vertex, dead ones dropped lazily
+			std::vector<unsigned> m_stamp;              // bumped whenever the quadric changes
+			std::vector<bool> m_removed;
+			std::vector<bool> m_dead;
+			std::priority_queue<Collapse> m_heap;
+			std::vector<int> m_from_ring;
+			std::vector<int> m_to_ring;
+			size_t m_live;
+			double m_error;
+		};
+	}
+
+	void MeshSimplifier::buildChain(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices,
+		const std::vector<float>& ratios, std::vector<int>& lod_indices, std::vector<MeshLod>& lods) {
+		lod_indices.clear();
+		lods.assign(1, MeshLod());
+		lods[0].count = indices.size();
+		size_t n_triangles = indices.size() / 3;
+
+		// one run, sampled at each target, so every level refines the next
+		Simplifier simplifier(vertices, indices);
+		std::vector<int> level;
+		std::vector<size_t> clusters;
+		size_t previous = n_triangles;
+		for (float ratio : ratios) {
+			size_t target = (size_t)(ratio * n_triangles);
+			if (target < s_min_triangles) { break; }
+			simplifier.reduce(target);
+			if (simplifier.live() >= previous) { continue; }
+			previous = simplifier.live();
+			simplifier.emit(level);
+			MeshOptimizer::tipsify(level, vertices.size(), MeshOptimizer::s_cache_size, clusters);
+			MeshOptimizer::orderClusters(vertices, level, clusters);
+
+			MeshLod lod;
+			lod.first = indices.size() + lod_indices.size();
+			lod.count = level.size();
+			// the summed squared plane distances, as a distance
+			lod.error = (float)std::sqrt(simplifier.error());
+			lods.push_back(lod);
+			lod_indices.insert(lod_indices.end(), level.begin(), level.end());
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef __MESH_SIMPLIFIER_H__
+#define __MESH_SIMPLIFIER_H__
+
+#include <glm/vec3.hpp> // glm::vec3
+
+#include <cstddef>
+#include <vector>
+
+namespace SceneEditor {
+
+	// One level of detail: a range of the mesh's index buffer over the shared vertices
+	struct MeshLod {
+		size_t first = 0;   // first index
+		size_t count = 0;   // number of indices
+		float error = 0.f;  // geometric error in mesh units, 0 for the full mesh
+		size_t first_meshlet = 0;  // see Meshlets; no meshlets means the range is drawn whole
+		size_t meshlet_count = 0;
+	};
+
+	/* [MESH SIMPLIFIER]
+	* Quadric error edge collapse (Garland & Heckbert 1997) restricted to
+	* the existing vertices: an edge collapses onto one of its endpoints,
+	* so every level of detail indexes the same vertex buffer. Boundary
+	* edges get extra perpendicular planes to hold the outline, and a
+	* collapse is refused if it would flip a face or pinch the surface.
+	*/
+	class MeshSimplifier {
+	public:
+		// Levels below this many triangles are not generated
+		static const size_t s_min_triangles = 32;
+
+		// Triangle count of each level against the full mesh, finest first
+		static std::vector<float> s_lod_ratios;
+
+		// Appends one cache ordered index list per ratio to lod_indices. lods
+		// gets the full mesh first, then every level that has fewer triangles
+		// than the one before; first is counted from the start of indices.
+		static void buildChain(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices,
+			const std::vector<float>& ratios, std::vector<int>& lod_indices, std::vector<MeshLod>& lods);
+	};
+}
+
+#endif // __MESH_SIMPLIFIER_H__
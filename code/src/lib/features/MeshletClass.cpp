@@ -0,0 +1,166 @@
+#include "MeshletClass.h"
+
+#include <glm/glm.hpp> // glm::cross, glm::dot, glm::length, glm::normalize
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace SceneEditor {
+
+	namespace {
+
+		// Bounds and normal cone of the triangles indices[first, first + count)
+		Meshlet bound(const std::vector<glm::vec3>& vertices, const int* indices, size_t first, size_t count) {
+			Meshlet meshlet;
+			meshlet.first = (uint32_t)first;
+			meshlet.count = (uint32_t)count;
+
+			glm::vec3 lo(std::numeric_limits<float>::max());
+			glm::vec3 hi(std::numeric_limits<float>::lowest());
+			glm::vec3 axis(0.f);
+			for (size_t i = 0; i < count; i += 3) {
+				const glm::vec3& a = vertices[indices[i]];
+				const glm::vec3& b = vertices[indices[i + 1]];
+				const glm::vec3& c = vertices[indices[i + 2]];
+				lo = glm::min(lo, glm::min(a, glm::min(b, c)));
+				hi = glm::max(hi, glm::max(a, glm::max(b, c)));
+				glm::vec3 n = glm::cross(b - a, c - b);
+				float length = glm::length(n);
+				if (length > 0.f) { axis += n / length; }
+			}
+			meshlet.center = (lo + hi) * .5f;
+			meshlet.radius = 0.f;
+			for (size_t i = 0; i < count; ++i) {
+				meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]] - meshlet.center));
+			}
+
+			// the cone has to hold every face; wider than ~84 degrees it never culls anything
+			float axis_length = glm::length(axis);
+			meshlet.cone_axis = axis_length > 0.f ? axis / axis_length : glm::vec3(0.f, 0.f, 1.f);
+			float min_dot = axis_length > 0.f ? 1.f : -1.f;
+			for (size_t i = 0; i < count; i += 3) {
+				const glm::vec3& a = vertices[indices[i]];
+				const glm::vec3& b = vertices[indices[i + 1]];
+				const glm::vec3& c = vertices[indices[i + 2]];
+				glm::vec3 n = glm::cross(b - a, c - b);
+				float length = glm::length(n);
+				if (length > 0.f) { min_dot = std::min(min_dot, glm::dot(n / length, meshlet.cone_axis)); }
+			}
+			meshlet.cone_cutoff = min_dot <= .1f ? 1.f : std::sqrt(1.f - min_dot * min_dot);
+			return meshlet;
+		}
+
+		// Splits one level in order; first is where indices starts in the element buffer
+		void split(const std::vector<glm::vec3>& vertices, const int* indices, size_t first, size_t count,
+			std::vector<uint32_t>& stamp, uint32_t& generation, std::vector<Meshlet>& meshlets) {
+			size_t begin = 0;
+			size_t n_vertices = 0;
+			++generation;
+			for (size_t i = 0; i < count; i += 3) {
+				size_t fresh = 0;
+				for (int c = 0; c < 3; ++c) {
+					if (stamp[indices[i + c]] != generation) { ++fresh; }
+				}
+				if (n_vertices + fresh > Meshlets::s_max_vertices || (i - begin) / 3 + 1 > Meshlets::s_max_triangles) {
+					meshlets.push_back(bound(vertices, indices + begin, first + begin, i - begin));
+					begin = i;
+					n_vertices = 0;
+					++generation;
+				}
+				for (int c = 0; c < 3; ++c) {
+					if (stamp[indices[i + c]] != generation) {
+						stamp[indices[i + c]] = generation;
+						++n_vertices;
+					}
+				}
+			}
+			if (count > begin) {
+				meshlets.push_back(bound(vertices, indices + begin, first + begin, count - begin));
+			}
+		}
+	}
+
+	void Meshlets::build(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices,
+		const std::vector<int>& lod_indices, std::vector<MeshLod>& lods, std::vector<Meshlet>& meshlets) {
+		meshlets.clear();
+		std::vector<uint32_t> stamp(vertices.size(), 0);
+		uint32_t generation = 0;
+		for (auto&& lod : lods) {
+			lod.first_meshlet = meshlets.size();
+			lod.meshlet_count = 0;
+			if (lod.count / 3 < s_min_triangles) { continue; }
+			const int* level = lod.first < indices.size()
+				? indices.data() + lod.first
+				: lod_indices.data() + (lod.first - indices.size());
+			split(vertices, level, lod.first, lod.count, stamp, generation, meshlets);
+			lod.meshlet_count = meshlets.size() - lod.first_meshlet;
+		}
+	}
+
+	bool Meshlets::closed(const std::vector<int>& indices) {
+		std::vector<std::pair<int, int>> edges;
+		edges.reserve(indices.size());
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			for (int c = 0; c < 3; ++c) {
+				int a = indices[i + c];
+				int b = indices[i + (c + 1) % 3];
+				edges.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+			}
+		}
+		if (edges.empty()) { return false; }
+		std::sort(edges.begin(), edges.end());
+		for (size_t i = 0; i < edges.size(); ) {
+			size_t j = i + 1;
+			while (j < edges.size() && edges[j] == edges[i]) { ++j; }
+			if (j - i != 2) { return false; }
+			i = j;
+		}
+		return true;
+	}
+
+	void Meshlets::cull(const Meshlet* meshlets, size_t count, const glm::mat4& model,
+		const std::vector<glm::mat4>& clip_volumes, const glm::vec3& eye, bool cones,
+		std::vector<int>& visible) {
+		visible.clear();
+		// clip planes from the rows of each matrix (Gribb & Hartmann), with the length of their normal
+		std::vector<glm::vec4> planes;
+		std::vector<float> lengths;
+		for (auto&& clip : clip_volumes) {
+			glm::mat4 rows = glm::transpose(clip);
+			glm::vec4 volume[6] = {
+				rows[3] + rows[0], rows[3] - rows[0],
+				rows[3] + rows[1], rows[3] - rows[1],
+				rows[3] + rows[2], rows[3] - rows[2]
+			};
+			for (int i = 0; i < 6; ++i) {
+				planes.push_back(volume[i]);
+				lengths.push_back(glm::length(glm::vec3(volume[i])));
+			}
+		}
+		// objects only scale uniformly, so spheres stay spheres and cones keep their angle
+		float scale = glm::length(glm::vec3(model[0]));
+		glm::mat3 rotation = glm::mat3(model) / (scale > 0.f ? scale : 1.f);
+
+		for (size_t m = 0; m < count; ++m) {
+			const Meshlet& meshlet = meshlets[m];
+			glm::vec3 center = glm::vec3(model * glm::vec4(meshlet.center, 1.f));
+			float radius = meshlet.radius * scale;
+			if (cones && meshlet.cone_cutoff < 1.f) {
+				glm::vec3 to_center = center - eye;
+				if (glm::dot(to_center, rotation * meshlet.cone_axis) >= meshlet.cone_cutoff * glm::length(to_center) + radius) {
+					continue;
+				}
+			}
+			bool inside = planes.empty();
+			for (size_t v = 0; v < planes.size() && !inside; v += 6) {
+				bool outside = false;
+				for (size_t i = v; i < v + 6 && !outside; ++i) {
+					outside = glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius * lengths[i];
+				}
+				inside = !outside;
+			}
+			if (inside) { visible.push_back((int)m); }
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef __MESHLET_H__
+#define __MESHLET_H__
+
+#include "MeshSimplifierClass.h"
+
+#include <glm/vec3.hpp> // glm::vec3
+#include <glm/mat4x4.hpp> // glm::mat4
+
+#include <cstdint>
+#include <vector>
+
+namespace SceneEditor {
+
+	// A run of triangles in the element buffer with its bounds, in mesh space
+	struct Meshlet {
+		uint32_t first;        // first index
+		uint32_t count;        // number of indices
+		glm::vec3 center;      // bounding sphere
+		float radius;
+		glm::vec3 cone_axis;   // average facing of the triangles
+		float cone_cutoff;     // sine of the normal cone's half angle; 1 never culls
+	};
+
+	/* [MESHLETS]
+	* Cuts each level of detail into meshlets of at most s_max_vertices
+	* distinct vertices and s_max_triangles triangles. The triangles are
+	* taken in their (cache optimized) order, so a meshlet is a plain range
+	* of the index buffer and the buffer itself does not change.
+	* Culling tests the bounding sphere against clip volumes and the normal
+	* cone against the eye (Shirman & Abi-Ezzi style, as in meshoptimizer).
+	*/
+	class Meshlets {
+	public:
+		static const size_t s_max_vertices = 64;
+		static const size_t s_max_triangles = 124;
+		// levels with fewer triangles are drawn whole
+		static const size_t s_min_triangles = 512;
+
+		// Meshlets of every level with at least s_min_triangles triangles; sets
+		// first_meshlet/meshlet_count of those levels. lods index indices followed by lod_indices.
+		static void build(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices,
+			const std::vector<int>& lod_indices, std::vector<MeshLod>& lods, std::vector<Meshlet>& meshlets);
+
+		// True if every edge of the triangle list has exactly two faces
+		static bool closed(const std::vector<int>& indices);
+
+		/* Indices (into meshlets) of the meshlets that may be seen.
+		* - A meshlet is kept when its sphere touches any of the clip volumes
+		*   (view-projection matrices, world space); none keeps everything.
+		* - With cones set, meshlets facing away from eye are dropped. Only
+		*   valid for closed meshes without wireframe.
+		*/
+		static void cull(const Meshlet* meshlets, size_t count, const glm::mat4& model,
+			const std::vector<glm::mat4>& clip_volumes, const glm::vec3& eye, bool cones,
+			std::vector<int>& visible);
+	};
+}
+
+#endif // __MESHLET_H__
@@ -0,0 +1,118 @@
+#include "PickBufferClass.h"
+
+#include "MacroClass.h"
+
+#include <algorithm>
+
+namespace SceneEditor {
+
+	PickBuffer::PickBuffer() : m_pbo{ 0 }, m_fence{ 0 }, m_width{ 0 }, m_height{ 0 }, m_x{ 0 }, m_y{ 0 }, m_requested{ false } {}
+
+	void PickBuffer::init() {
+		m_fbo.init();
+		m_id_texture.init();
+		m_depth_texture.init();
+		glGenBuffers(1, &m_pbo);
+		StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, 2 * sizeof(GLuint), NULL, GL_STREAM_READ);
+		StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		check_gl_error();
+	}
+
+	void PickBuffer::free() {
+		cancel();
+		if (m_fence) {
+			glDeleteSync(m_fence);
+			m_fence = 0;
+		}
+		StateCache::forgetBuffer(m_pbo);
+		glDeleteBuffers(1, &m_pbo);
+		m_depth_texture.free();
+		m_id_texture.free();
+		m_fbo.free();
+	}
+
+	void PickBuffer::request(int x, int y, const Callback& callback) {
+		m_x = x;
+		m_y = y;
+		m_pending = callback;
+		m_requested = true;
+	}
+
+	void PickBuffer::cancel() {
+		m_requested = false;
+		m_pending = Callback();
+		m_reading = Callback();
+	}
+
+	void PickBuffer::resize(int width, int height) {
+		if (width == m_width && height == m_height) { return; }
+		m_width = width;
+		m_height = height;
+		m_id_texture.bind(GL_TEXTURE_2D);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, width, height, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		m_depth_texture.bind(GL_TEXTURE_2D);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		StateCache::bindTexture(GL_TEXTURE_2D, 0);
+
+		m_fbo.bind();
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_id_texture.id, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth_texture.id, 0);
+		m_fbo.check();
+		m_fbo.unbind();
+	}
+
+	void PickBuffer::begin(int width, int height) {
+		resize(width, height);
+		m_fbo.bind();
+		GLuint clear_id[4] = { 0, 0, 0, 0 };
+		glClearBufferuiv(GL_COLOR, 0, clear_id);
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+
+	void PickBuffer::end() {
+		// one read at a time; a newer request replaces the waiting one
+		if (m_requested && !m_fence) {
+			int x = std::min(std::max(m_x, 0), m_width - 1);
+			int y = std::min(std::max(m_y, 0), m_height - 1);
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+			StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+			glReadPixels(x, y, 1, 1, GL_RG_INTEGER, GL_UNSIGNED_INT, BUFFER_OFFSET(0));
+			StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			m_reading = m_pending;
+			m_pending = Callback();
+			m_requested = false;
+		}
+		m_fbo.unbind();
+		check_gl_error();
+	}
+
+	void PickBuffer::poll() {
+		if (!m_fence) { return; }
+		GLenum status = glClientWaitSync(m_fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) { return; }
+		glDeleteSync(m_fence);
+		m_fence = 0;
+
+		GLuint id[2] = { 0, 0 };
+		StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+		const GLuint* data = (const GLuint*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(id), GL_MAP_READ_BIT);
+		if (data) {
+			id[0] = data[0];
+			id[1] = data[1];
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		Callback callback;
+		std::swap(callback, m_reading);
+		if (callback) {
+			callback((int)id[0] - 1, (int)id[1] - 1);
+		}
+	}
+}
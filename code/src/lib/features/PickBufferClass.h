@@ -0,0 +1,57 @@
+#ifndef __PICK_BUFFER_H__
+#define __PICK_BUFFER_H__
+
+#include "../../helper/HelperClass.h"
+
+#include <functional>
+
+namespace SceneEditor {
+
+	/* [PICK BUFFER]
+	* Integer render target holding (object + 1, triangle + 1) per pixel,
+	* 0 meaning nothing. The pixel under the cursor is copied into a pixel
+	* buffer object and only read back once its fence has passed, so a
+	* request never waits for the GPU.
+	*/
+	class PickBuffer {
+	public:
+		// object and triangle are -1 when the pixel shows no object
+		typedef std::function<void(int object, int triangle)> Callback;
+
+		PickBuffer();
+		void init();
+		void free();
+
+		// Queues a read of pixel (x, y); callback runs from poll() a frame or more later
+		void request(int x, int y, const Callback& callback);
+		void cancel();
+		// True while a request waits for its ID pass (and no read is in flight)
+		bool wanted() const { return m_requested && !m_fence; }
+
+		// Binds the ID target (resized to width x height) and clears it
+		void begin(int width, int height);
+		// Starts the asynchronous read of the requested pixel and unbinds
+		void end();
+		// Delivers a finished read, if any
+		void poll();
+
+	private:
+		void resize(int width, int height);
+
+	private:
+		FrameBufferObject m_fbo;
+		Texture m_id_texture;
+		Texture m_depth_texture;
+		GLuint m_pbo;
+		GLsync m_fence;
+		int m_width;
+		int m_height;
+		int m_x;
+		int m_y;
+		bool m_requested;
+		Callback m_pending;  // request waiting for the ID pass
+		Callback m_reading;  // read in flight
+	};
+}
+
+#endif // __PICK_BUFFER_H__
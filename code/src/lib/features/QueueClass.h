@@ -0,0 +1,88 @@
+#ifndef __QUEUE_H__
+#define __QUEUE_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace SceneEditor {
+
+	// Blocking FIFO with a fixed capacity, used between worker stages.
+	// push() waits while the queue is full, pop() while it is empty.
+	template<typename T>
+	class BoundedQueue {
+	public:
+		explicit BoundedQueue(size_t capacity) : m_capacity{ capacity }, m_closed{ false } {}
+
+		// Returns false once the queue is closed
+		bool push(T&& value) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_not_full.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+			if (m_closed) { return false; }
+			m_items.push_back(std::move(value));
+			m_not_empty.notify_one();
+			return true;
+		}
+
+		// Returns false once the queue is closed and drained
+		bool pop(T& value) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_not_empty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+			if (m_items.empty()) { return false; }
+			value = std::move(m_items.front());
+			m_items.pop_front();
+			m_not_full.notify_one();
+			return true;
+		}
+
+		void close() {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_closed = true;
+			m_not_full.notify_all();
+			m_not_empty.notify_all();
+		}
+
+	private:
+		std::deque<T> m_items;
+		size_t m_capacity;
+		bool m_closed;
+		std::mutex m_mutex;
+		std::condition_variable m_not_full;
+		std::condition_variable m_not_empty;
+	};
+
+	// Lock-free single-producer/single-consumer ring buffer. N must be a power of two.
+	template<typename T, size_t N>
+	class SpscQueue {
+		static_assert((N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+	public:
+		SpscQueue() : m_head{ 0 }, m_tail{ 0 } {}
+
+		// Producer side; returns false if the ring is full
+		bool push(T&& value) {
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_head.load(std::memory_order_acquire) == N) { return false; }
+			m_slots[tail & (N - 1)] = std::move(value);
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer side; returns false if the ring is empty
+		bool pop(T& value) {
+			size_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_tail.load(std::memory_order_acquire)) { return false; }
+			value = std::move(m_slots[head & (N - 1)]);
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		T m_slots[N];
+		std::atomic<size_t> m_head;
+		std::atomic<size_t> m_tail;
+	};
+}
+
+#endif // __QUEUE_H__
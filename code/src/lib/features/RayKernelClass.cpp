@@ -0,0 +1,217 @@
+#include "RayKernelClass.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAY_KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define RAY_KERNEL_AVX2
+#elif defined(__GNUC__)
+#define RAY_KERNEL_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace SceneEditor {
+
+	namespace {
+
+		const int W = TrianglePacket::s_width;
+
+		typedef bool(*Kernel)(const TrianglePacket&, const glm::vec3&, const glm::vec3&, float, float&);
+
+		bool intersectScalar(const TrianglePacket& p, const glm::vec3& e, const glm::vec3& d, float vnear, float& vfar) {
+			bool hit = false;
+			for (int i = 0; i < W; ++i) {
+				glm::vec3 e1(p.e1[0][i], p.e1[1][i], p.e1[2][i]);
+				glm::vec3 e2(p.e2[0][i], p.e2[1][i], p.e2[2][i]);
+				glm::vec3 s = e - glm::vec3(p.v0[0][i], p.v0[1][i], p.v0[2][i]);
+				glm::vec3 q = glm::vec3(d.y * e2.z - d.z * e2.y, d.z * e2.x - d.x * e2.z, d.x * e2.y - d.y * e2.x);
+				float det = e1.x * q.x + e1.y * q.y + e1.z * q.z;
+				if (det == 0.f) { continue; }
+				float inv_det = 1.f / det;
+				float u = (s.x * q.x + s.y * q.y + s.z * q.z) * inv_det;
+				if (u < 0.f || u > 1.f) { continue; }
+				glm::vec3 r = glm::vec3(s.y * e1.z - s.z * e1.y, s.z * e1.x - s.x * e1.z, s.x * e1.y - s.y * e1.x);
+				float v = (d.x * r.x + d.y * r.y + d.z * r.z) * inv_det;
+				if (v < 0.f || u + v > 1.f) { continue; }
+				float t = (e2.x * r.x + e2.y * r.y + e2.z * r.z) * inv_det;
+				if (t >= vnear && t <= vfar) {
+					vfar = t;
+					hit = true;
+				}
+			}
+			return hit;
+		}
+
+#ifdef RAY_KERNEL_X86
+		// 4 lanes starting at lane; returns t (or +inf) per lane
+		inline __m128 intersect4(const TrianglePacket& p, int lane, const glm::vec3& e, const glm::vec3& d, float vnear, float vfar) {
+			__m128 dx = _mm_set1_ps(d.x), dy = _mm_set1_ps(d.y), dz = _mm_set1_ps(d.z);
+			__m128 e1x = _mm_loadu_ps(p.e1[0] + lane), e1y = _mm_loadu_ps(p.e1[1] + lane), e1z = _mm_loadu_ps(p.e1[2] + lane);
+			__m128 e2x = _mm_loadu_ps(p.e2[0] + lane), e2y = _mm_loadu_ps(p.e2[1] + lane), e2z = _mm_loadu_ps(p.e2[2] + lane);
+			__m128 sx = _mm_sub_ps(_mm_set1_ps(e.x), _mm_loadu_ps(p.v0[0] + lane));
+			__m128 sy = _mm_sub_ps(_mm_set1_ps(e.y), _mm_loadu_ps(p.v0[1] + lane));
+			__m128 sz = _mm_sub_ps(_mm_set1_ps(e.z), _mm_loadu_ps(p.v0[2] + lane));
+
+			__m128 qx = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+			__m128 qy = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+			__m128 qz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+			__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, qx), _mm_mul_ps(e1y, qy)), _mm_mul_ps(e1z, qz));
+			__m128 inv_det = _mm_div_ps(_mm_set1_ps(1.f), det);
+			__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, qx), _mm_mul_ps(sy, qy)), _mm_mul_ps(sz, qz)), inv_det);
+
+			__m128 rx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+			__m128 ry = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+			__m128 rz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+			__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, rx), _mm_mul_ps(dy, ry)), _mm_mul_ps(dz, rz)), inv_det);
+			__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, rx), _mm_mul_ps(e2y, ry)), _mm_mul_ps(e2z, rz)), inv_det);
+
+			__m128 zero = _mm_setzero_ps();
+			__m128 mask = _mm_cmpneq_ps(det, zero);
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+			mask = _mm_and_ps(mask, _mm_cmple_ps(u, _mm_set1_ps(1.f)));
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+			mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.f)));
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(t, _mm_set1_ps(vnear)));
+			mask = _mm_and_ps(mask, _mm_cmple_ps(t, _mm_set1_ps(vfar)));
+			// blend: t where hit, +inf elsewhere
+			__m128 inf = _mm_set1_ps(HUGE_VALF);
+			return _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, inf));
+		}
+
+		bool intersectSse(const TrianglePacket& p, const glm::vec3& e, const glm::vec3& d, float vnear, float& vfar) {
+			__m128 t = _mm_min_ps(intersect4(p, 0, e, d, vnear, vfar), intersect4(p, 4, e, d, vnear, vfar));
+			t = _mm_min_ps(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 3, 0, 1)));
+			t = _mm_min_ps(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 0, 3, 2)));
+			float best = _mm_cvtss_f32(t);
+			if (best > vfar) { return false; }
+			vfar = best;
+			return true;
+		}
+
+#ifdef RAY_KERNEL_AVX2
+		RAY_KERNEL_AVX2 bool intersectAvx2(const TrianglePacket& p, const glm::vec3& e, const glm::vec3& d, float vnear, float& vfar) {
+			__m256 dx = _mm256_set1_ps(d.x), dy = _mm256_set1_ps(d.y), dz = _mm256_set1_ps(d.z);
+			__m256 e1x = _mm256_loadu_ps(p.e1[0]), e1y = _mm256_loadu_ps(p.e1[1]), e1z = _mm256_loadu_ps(p.e1[2]);
+			__m256 e2x = _mm256_loadu_ps(p.e2[0]), e2y = _mm256_loadu_ps(p.e2[1]), e2z = _mm256_loadu_ps(p.e2[2]);
+			__m256 sx = _mm256_sub_ps(_mm256_set1_ps(e.x), _mm256_loadu_ps(p.v0[0]));
+			__m256 sy = _mm256_sub_ps(_mm256_set1_ps(e.y), _mm256_loadu_ps(p.v0[1]));
+			__m256 sz = _mm256_sub_ps(_mm256_set1_ps(e.z), _mm256_loadu_ps(p.v0[2]));
+
+			__m256 qx = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+			__m256 qy = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+			__m256 qz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+			__m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, qx), _mm256_mul_ps(e1y, qy)), _mm256_mul_ps(e1z, qz));
+			__m256 inv_det = _mm256_div_ps(_mm256_set1_ps(1.f), det);
+			__m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, qx), _mm256_mul_ps(sy, qy)), _mm256_mul_ps(sz, qz)), inv_det);
+
+			__m256 rx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+			__m256 ry = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+			__m256 rz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+			__m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, rx), _mm256_mul_ps(dy, ry)), _mm256_mul_ps(dz, rz)), inv_det);
+			__m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, rx), _mm256_mul_ps(e2y, ry)), _mm256_mul_ps(e2z, rz)), inv_det);
+
+			__m256 zero = _mm256_setzero_ps();
+			__m256 one = _mm256_set1_ps(1.f);
+			__m256 mask = _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ);
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, one, _CMP_LE_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, _mm256_set1_ps(vnear), _CMP_GE_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, _mm256_set1_ps(vfar), _CMP_LE_OQ));
+			if (_mm256_testz_ps(mask, mask)) { return false; }
+
+			t = _mm256_blendv_ps(_mm256_set1_ps(HUGE_VALF), t, mask);
+			__m128 m = _mm_min_ps(_mm256_castps256_ps128(t), _mm256_extractf128_ps(t, 1));
+			m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+			m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+			vfar = _mm_cvtss_f32(m);
+			return true;
+		}
+
+		bool hasAvx2() {
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7) { return false; }
+			__cpuid(info, 1);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			// the OS must save the upper halves of the ymm registers
+			if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) { return false; }
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") != 0;
+#endif
+		}
+#endif
+#endif
+
+		const char* const s_names[RayKernel::N_ISA] = { "SCALAR", "SSE", "AVX2" };
+
+		struct Dispatch {
+			Kernel kernels[RayKernel::N_ISA];  // nullptr where unsupported
+			Kernel kernel;
+			const char* name;
+
+			Dispatch() : kernels{ intersectScalar, nullptr, nullptr } {
+#ifdef RAY_KERNEL_X86
+				kernels[RayKernel::SSE] = intersectSse;
+#ifdef RAY_KERNEL_AVX2
+				if (hasAvx2()) {
+					kernels[RayKernel::AVX2] = intersectAvx2;
+				}
+#endif
+#endif
+				// the widest one available
+				int isa = RayKernel::N_ISA - 1;
+				while (!kernels[isa]) { --isa; }
+				kernel = kernels[isa];
+				name = s_names[isa];
+			}
+		};
+
+		const Dispatch& dispatch() {
+			static const Dispatch s_dispatch;
+			return s_dispatch;
+		}
+	}
+
+	void RayKernel::pack(TrianglePacket& packet, int lane, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+		for (int k = 0; k < 3; ++k) {
+			packet.v0[k][lane] = a[k];
+			packet.e1[k][lane] = b[k] - a[k];
+			packet.e2[k][lane] = c[k] - a[k];
+		}
+	}
+
+	void RayKernel::clear(TrianglePacket& packet) {
+		std::memset(&packet, 0, sizeof(packet));
+	}
+
+	bool RayKernel::intersect(const TrianglePacket& packet, const glm::vec3& e, const glm::vec3& d, float vnear, float& vfar) {
+		return dispatch().kernel(packet, e, d, vnear, vfar);
+	}
+
+	const char* RayKernel::isa() {
+		return dispatch().name;
+	}
+
+	bool RayKernel::supported(Isa isa) {
+		return isa >= 0 && isa < N_ISA && dispatch().kernels[isa] != nullptr;
+	}
+
+	const char* RayKernel::name(Isa isa) {
+		return s_names[isa];
+	}
+
+	bool RayKernel::intersect(Isa isa, const TrianglePacket& packet, const glm::vec3& e, const glm::vec3& d, float vnear, float& vfar) {
+		return dispatch().kernels[isa](packet, e, d, vnear, vfar);
+	}
+}
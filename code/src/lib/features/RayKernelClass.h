@@ -0,0 +1,47 @@
+#ifndef __RAY_KERNEL_H__
+#define __RAY_KERNEL_H__
+
+#include <glm/vec3.hpp> // glm::vec3
+
+namespace SceneEditor {
+
+	/* [TRIANGLE PACKET]
+	* Up to s_width triangles in structure-of-arrays layout, pre-split into
+	* a vertex and two edges for Möller–Trumbore. Unused lanes have zero
+	* edges, which the kernels reject as degenerate.
+	*/
+	struct TrianglePacket {
+		static const int s_width = 8;
+
+		float v0[3][s_width];
+		float e1[3][s_width];
+		float e2[3][s_width];
+	};
+
+	/* [RAY KERNEL]
+	* Ray against a whole TrianglePacket. The implementation (AVX2, SSE or
+	* scalar) is picked once from the running CPU; tests and benchmarks can
+	* call a given one through the Isa overload.
+	*/
+	class RayKernel {
+	public:
+		enum Isa { SCALAR, SSE, AVX2, N_ISA };
+
+		// Fills lane (< s_width) with triangle abc
+		static void pack(TrianglePacket& packet, int lane, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+		// Empties every lane
+		static void clear(TrianglePacket& packet);
+		// Closest hit with t in [near, far]; on a hit far is lowered to it
+		static bool intersect(const TrianglePacket& packet, const glm::vec3& e, const glm::vec3& d, float near, float& far);
+		// Name of the selected implementation
+		static const char* isa();
+
+		// Whether this build and CPU can run isa
+		static bool supported(Isa isa);
+		static const char* name(Isa isa);
+		// intersect() with the given implementation, which must be supported
+		static bool intersect(Isa isa, const TrianglePacket& packet, const glm::vec3& e, const glm::vec3& d, float near, float& far);
+	};
+}
+
+#endif // __RAY_KERNEL_H__
@@ -0,0 +1,98 @@
+#include "ReflectionBufferClass.h"
+
+#include <glm/glm.hpp> // glm::inverse
+
+namespace SceneEditor {
+
+	static const GLenum draw_buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+
+	ReflectionBuffer::ReflectionBuffer() : m_width{ 0 }, m_height{ 0 } {}
+
+	void ReflectionBuffer::init() {
+		m_fbo.init();
+		m_color_texture.init();
+		m_depth_texture.init();
+		m_reflect_texture.init();
+		m_vao.init();
+		check_gl_error();
+	}
+
+	void ReflectionBuffer::free() {
+		m_vao.free();
+		m_reflect_texture.free();
+		m_depth_texture.free();
+		m_color_texture.free();
+		m_fbo.free();
+		m_width = 0;
+		m_height = 0;
+	}
+
+	void ReflectionBuffer::resize(int width, int height) {
+		if (width == m_width && height == m_height) { return; }
+		m_width = width;
+		m_height = height;
+		struct { Texture* texture; GLint internal_format; GLenum format; GLenum type; } targets[3] = {
+			{ &m_color_texture, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE },
+			{ &m_reflect_texture, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT },
+			{ &m_depth_texture, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT }
+		};
+		for (auto&& target : targets) {
+			target.texture->bind(GL_TEXTURE_2D);
+			glTexImage2D(GL_TEXTURE_2D, 0, target.internal_format, width, height, 0, target.format, target.type, NULL);
+			// hits are read back exactly where they were found
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+		StateCache::bindTexture(GL_TEXTURE_2D, 0);
+
+		m_fbo.bind();
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_color_texture.id, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_reflect_texture.id, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth_texture.id, 0);
+		m_fbo.check();
+		m_fbo.unbind();
+	}
+
+	void ReflectionBuffer::begin(int width, int height) {
+		resize(width, height);
+		m_fbo.bind();
+		glDrawBuffers(2, draw_buffers);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		GLfloat no_mirror[4] = { 0.f, 0.f, 0.f, 0.f };
+		glClearBufferfv(GL_COLOR, 1, no_mirror);
+		// the other shaders leave the second output undefined
+		glDrawBuffers(1, draw_buffers);
+	}
+
+	void ReflectionBuffer::mirrors() {
+		glDrawBuffers(2, draw_buffers);
+	}
+
+	void ReflectionBuffer::resolve(Program& program, Texture& skybox_texture, const glm::mat4& view_proj, float max_distance) {
+		glDrawBuffers(1, draw_buffers);
+		m_fbo.unbind();
+
+		program.bind();
+		glm::mat4 inverse_view_proj = glm::inverse(view_proj);
+		glUniformMatrix4fv(program.uniform("inverseViewProj"), 1, GL_FALSE, &inverse_view_proj[0][0]);
+		glUniform1f(program.uniform("maxDistance"), max_distance);
+		StateCache::activeTexture(GL_TEXTURE0);
+		m_color_texture.bind(GL_TEXTURE_2D);
+		StateCache::activeTexture(GL_TEXTURE1);
+		m_depth_texture.bind(GL_TEXTURE_2D);
+		StateCache::activeTexture(GL_TEXTURE2);
+		m_reflect_texture.bind(GL_TEXTURE_2D);
+		StateCache::activeTexture(GL_TEXTURE3);
+		skybox_texture.bind(GL_TEXTURE_CUBE_MAP);
+
+		// every pixel is written, depth too, so the default framebuffer needs no clear
+		StateCache::polygonMode(GL_FILL);
+		glDepthFunc(GL_ALWAYS);
+		m_vao.bind();
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glDepthFunc(GL_LESS);
+		check_gl_error();
+	}
+}
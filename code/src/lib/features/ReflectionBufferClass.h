@@ -0,0 +1,47 @@
+#ifndef __REFLECTION_BUFFER_H__
+#define __REFLECTION_BUFFER_H__
+
+#include "../../helper/HelperClass.h"
+
+#include <glm/mat4x4.hpp> // glm::mat4
+
+namespace SceneEditor {
+
+	/* [REFLECTION BUFFER]
+	* Off-screen target for the main pass while screen-space mirrors are in
+	* view: scene color and depth, plus a second attachment where mirrors
+	* leave their world normal and light factor (0 everywhere else). One
+	* full-screen pass then traces every mirror pixel against the depth and
+	* color and writes the frame, depth included, to the default framebuffer.
+	* Rays that leave the screen fall back to the static skybox, so the cost
+	* does not depend on how many mirrors there are.
+	*/
+	class ReflectionBuffer {
+	public:
+		ReflectionBuffer();
+		void init();
+		void free();
+
+		// Binds the target (resized to width x height), clears it and draws color only
+		void begin(int width, int height);
+		// Draws color and the mirror attachment; mirrors have to come after everything else
+		void mirrors();
+		// Traces the mirror pixels with program into the default framebuffer.
+		// view_proj is the main pass clip space, AspectRatioMatrix * VPMatrix.
+		void resolve(Program& program, Texture& skybox_texture, const glm::mat4& view_proj, float max_distance);
+
+	private:
+		void resize(int width, int height);
+
+	private:
+		FrameBufferObject m_fbo;
+		Texture m_color_texture;
+		Texture m_depth_texture;
+		Texture m_reflect_texture;
+		VertexArrayObject m_vao;  // empty, the full-screen triangle needs no vertices
+		int m_width;
+		int m_height;
+	};
+}
+
+#endif // __REFLECTION_BUFFER_H__
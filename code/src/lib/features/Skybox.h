@@ -11,11 +11,10 @@ namespace SceneEditor {
 	public:
 		void init();
 		void free();
-		void bind();
 		void update();
 		void configCubeMap();
-		void draw(Program& program, ViewControl& view_control, bool isEnvMap = false);
-		void drawEnvMapping(Program& program, ViewControl& view_control, glm::mat4& envVPMatrix);
+		// Camera and aspect come from the Frame block, or faceMatrices for the cube layer variant
+		void draw(Program& program, GLsizei instances = 1);
 		Texture getTexture() const;
 	private:
 		VertexArrayObject m_vao;
@@ -23,8 +22,6 @@ namespace SceneEditor {
 		Texture m_texture;
 		static std::vector<glm::vec3> m_vertices;
 		static std::vector<std::string> skybox_faces;
-
-		glm::mat4 m_envVPMatrix;
 	};
 }
 
@@ -36,12 +36,10 @@ namespace SceneEditor {
 		m_texture.free();
 	}
 
-	void Skybox::bind() {
-		m_vao.bind();
-	}
-
 	void Skybox::update() {
+		m_vao.bind();
 		m_vbo.update(m_vertices);
+		m_vao.attribute(POSITION_ATTRIB, m_vbo);
 	}
 
 	void Skybox::configCubeMap() {
@@ -70,32 +68,19 @@ namespace SceneEditor {
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 	}
 
-	void Skybox::draw(Program& program, ViewControl& view_control, bool isEnvMap) {
+	void Skybox::draw(Program& program, GLsizei instances) {
 		program.bind();
+		StateCache::polygonMode(GL_FILL);
+		StateCache::activeTexture(GL_TEXTURE0);
+		m_texture.bind(GL_TEXTURE_CUBE_MAP);
 
-		glm::mat4 VPMatrix, aspectRatioMatrix;
-		if (isEnvMap) {
-			VPMatrix = m_envVPMatrix;
-			aspectRatioMatrix = glm::mat4(1.f);
+		m_vao.bind();
+		if (instances == 1) {
+			glDrawArrays(GL_TRIANGLES, 0, m_vertices.size());
 		}
 		else {
-			VPMatrix = view_control.getProjMatrix() * glm::mat4(glm::mat3(view_control.getViewMatrix()));
-			aspectRatioMatrix = view_control.getAspectRatioMatrix();
+			glDrawArraysInstanced(GL_TRIANGLES, 0, m_vertices.size(), instances);
 		}
-		GLint uniVPMatrix = program.uniform("VPMatrix");
-		glUniformMatrix4fv(uniVPMatrix, 1, GL_FALSE, glm::value_ptr(VPMatrix));
-		GLint uniAR = program.uniform("AspectRatioMatrix");
-		glUniformMatrix4fv(uniAR, 1, GL_FALSE, glm::value_ptr(aspectRatioMatrix));
-		glActiveTexture(GL_TEXTURE0);
-		m_texture.bind(GL_TEXTURE_CUBE_MAP);
-
-		program.bindVertexAttribArray("position", m_vbo);
-		glDrawArrays(GL_TRIANGLES, 0, m_vertices.size());
-	}
-
-	void Skybox::drawEnvMapping(Program& program, ViewControl& view_control, glm::mat4& envVPMatrix) {
-		m_envVPMatrix = envVPMatrix;
-		draw(program, view_control, true);
 	}
 
 	Texture Skybox::getTexture() const {
@@ -0,0 +1,134 @@
+#include "VertexFormatClass.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp> // glm::packHalf1x16, glm::packUnorm1x16, glm::packSnorm3x10_1x2
+#include <glm/gtc/matrix_transform.hpp> // glm::translate, glm::scale
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace SceneEditor {
+
+	static const GLsizei position_bytes[] = { 3 * sizeof(float), 4 * sizeof(uint16_t), 4 * sizeof(uint16_t) };
+	static const GLsizei normal_bytes[] = { 3 * sizeof(float), sizeof(uint32_t), 2 * sizeof(int16_t) };
+
+	VertexFormat::VertexFormat(Positions positions, Normals normals) : m_positions{ positions }, m_normals{ normals } {}
+
+	GLsizei VertexFormat::stride() const {
+		return position_bytes[m_positions] + normal_bytes[m_normals];
+	}
+
+	VertexAttrib VertexFormat::positionAttrib() const {
+		switch (m_positions) {
+		case HALF_POSITIONS: return VertexAttrib{ 3, GL_HALF_FLOAT, GL_FALSE, 0 };
+		case UNORM16_POSITIONS: return VertexAttrib{ 3, GL_UNSIGNED_SHORT, GL_TRUE, 0 };
+		default: return VertexAttrib{ 3, GL_FLOAT, GL_FALSE, 0 };
+		}
+	}
+
+	VertexAttrib VertexFormat::normalAttrib() const {
+		size_t offset = position_bytes[m_positions];
+		switch (m_normals) {
+		case PACKED_NORMALS: return VertexAttrib{ 4, GL_INT_2_10_10_10_REV, GL_TRUE, offset };
+		case OCTAHEDRAL_NORMALS: return VertexAttrib{ 2, GL_SHORT, GL_TRUE, offset };
+		default: return VertexAttrib{ 3, GL_FLOAT, GL_FALSE, offset };
+		}
+	}
+
+	std::string VertexFormat::name() const {
+		static const char* positions[] = { "FLOAT", "HALF", "UNORM16" };
+		static const char* normals[] = { "FLOAT", "2_10_10_10", "OCTAHEDRAL" };
+		return std::string(positions[m_positions]) + " + " + normals[m_normals];
+	}
+
+	// Folds the upper hemisphere over the lower one; both components in [-1, 1]
+	static glm::vec2 octahedral(const glm::vec3& n) {
+		glm::vec3 a = n / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+		glm::vec2 e(a.x, a.y);
+		if (a.z < 0.f) {
+			e = (glm::vec2(1.f) - glm::abs(glm::vec2(e.y, e.x))) *
+				glm::vec2(e.x >= 0.f ? 1.f : -1.f, e.y >= 0.f ? 1.f : -1.f);
+		}
+		return e;
+	}
+
+	void VertexFormat::encode(const glm::vec3* positions, const glm::vec3* normals, size_t count,
+		std::vector<unsigned char>& out, glm::mat4& decode) const {
+		glm::vec3 lo(std::numeric_limits<float>::max());
+		glm::vec3 hi(std::numeric_limits<float>::lowest());
+		for (size_t i = 0; i < count; ++i) {
+			lo = glm::min(lo, positions[i]);
+			hi = glm::max(hi, positions[i]);
+		}
+		if (count == 0) { lo = hi = glm::vec3(0.f); }
+		// a flat axis (the plane) would divide by zero
+		glm::vec3 extent = glm::max(hi - lo, glm::vec3(1e-6f));
+		glm::vec3 center = (lo + hi) * .5f;
+
+		decode = glm::mat4(1.f);
+		if (m_positions == HALF_POSITIONS) {
+			decode = glm::scale(glm::translate(glm::mat4(1.f), center), extent * .5f);
+		}
+		else if (m_positions == UNORM16_POSITIONS) {
+			decode = glm::scale(glm::translate(glm::mat4(1.f), lo), extent);
+		}
+
+		GLsizei size = stride();
+		size_t normal_offset = position_bytes[m_positions];
+		out.assign(count * size, 0);
+		for (size_t i = 0; i < count; ++i) {
+			unsigned char* vertex = out.data() + i * size;
+			const glm::vec3& p = positions[i];
+			if (m_positions == FLOAT_POSITIONS) {
+				std::memcpy(vertex, &p, sizeof(p));
+			}
+			else {
+				uint16_t q[4] = { 0, 0, 0, 0 };
+				for (int c = 0; c < 3; ++c) {
+					q[c] = m_positions == HALF_POSITIONS
+						? glm::packHalf1x16((p[c] - center[c]) / (extent[c] * .5f))
+						: glm::packUnorm1x16((p[c] - lo[c]) / extent[c]);
+				}
+				std::memcpy(vertex, q, sizeof(q));
+			}
+
+			glm::vec3 n = normals[i];
+			float length = glm::length(n);
+			n = length > 0.f ? n / length : glm::vec3(0.f, 0.f, 1.f);
+			unsigned char* normal = vertex + normal_offset;
+			if (m_normals == FLOAT_NORMALS) {
+				std::memcpy(normal, &n, sizeof(n));
+			}
+			else if (m_normals == PACKED_NORMALS) {
+				uint32_t packed = glm::packSnorm3x10_1x2(glm::vec4(n, 0.f));
+				std::memcpy(normal, &packed, sizeof(packed));
+			}
+			else {
+				glm::vec2 e = octahedral(n);
+				int16_t packed[2] = { (int16_t)glm::packSnorm1x16(e.x), (int16_t)glm::packSnorm1x16(e.y) };
+				std::memcpy(normal, packed, sizeof(packed));
+			}
+		}
+	}
+
+	size_t VertexFormat::indexBytes(size_t n_vertices) {
+		return n_vertices <= 65536 ? sizeof(uint16_t) : sizeof(int);
+	}
+
+	void VertexFormat::encodeIndices(const int* indices, size_t n_indices, const std::vector<int>& lod_indices,
+		size_t n_vertices, std::vector<unsigned char>& out) {
+		size_t n_total = n_indices + lod_indices.size();
+		out.resize(n_total * indexBytes(n_vertices));
+		if (indexBytes(n_vertices) == sizeof(int)) {
+			std::memcpy(out.data(), indices, n_indices * sizeof(int));
+			if (!lod_indices.empty()) {
+				std::memcpy(out.data() + n_indices * sizeof(int), lod_indices.data(), lod_indices.size() * sizeof(int));
+			}
+			return;
+		}
+		uint16_t* short_indices = reinterpret_cast<uint16_t*>(out.data());
+		std::copy(indices, indices + n_indices, short_indices);
+		std::copy(lod_indices.begin(), lod_indices.end(), short_indices + n_indices);
+	}
+}
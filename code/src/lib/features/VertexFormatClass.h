@@ -0,0 +1,59 @@
+#ifndef __VERTEX_FORMAT_H__
+#define __VERTEX_FORMAT_H__
+
+#include "../../helper/HelperClass.h"
+
+#include <glm/vec3.hpp> // glm::vec3
+#include <glm/mat4x4.hpp> // glm::mat4
+
+#include <vector>
+
+namespace SceneEditor {
+
+	/* [VERTEX FORMAT]
+	* GPU layout of a mesh: position and normal interleaved in one buffer,
+	* each in one of several encodings.
+	* - Quantized positions are stored relative to the mesh bounds. decode
+	*   maps them back to mesh space and is folded into the model matrix.
+	* - Octahedral normals need the OCTAHEDRAL_NORMALS shader define.
+	*/
+	class VertexFormat {
+	public:
+		enum Positions {
+			FLOAT_POSITIONS = 0,    // 3 x float, 12 bytes
+			HALF_POSITIONS = 1,     // 3 x half in [-1, 1] over the bounds, 8 bytes
+			UNORM16_POSITIONS = 2   // 3 x unorm16 in [0, 1] over the bounds, 8 bytes
+		};
+		enum Normals {
+			FLOAT_NORMALS = 0,      // 3 x float, 12 bytes
+			PACKED_NORMALS = 1,     // 2_10_10_10 snorm, 4 bytes
+			OCTAHEDRAL_NORMALS = 2  // 2 x snorm16 on the octahedron, 4 bytes
+		};
+
+		VertexFormat(Positions positions = UNORM16_POSITIONS, Normals normals = PACKED_NORMALS);
+
+		Positions positions() const { return m_positions; }
+		Normals normals() const { return m_normals; }
+		GLsizei stride() const;
+		VertexAttrib positionAttrib() const;
+		VertexAttrib normalAttrib() const;
+		// e.g. "UNORM16 + 2_10_10_10"
+		std::string name() const;
+
+		// Interleaves count vertices into out; decode takes stored positions to mesh space
+		void encode(const glm::vec3* positions, const glm::vec3* normals, size_t count,
+			std::vector<unsigned char>& out, glm::mat4& decode) const;
+
+		// 2 when every index into n_vertices fits in 16 bits, 4 otherwise
+		static size_t indexBytes(size_t n_vertices);
+		// The full mesh then the coarser levels, indexBytes(n_vertices) wide, as the element buffer takes them
+		static void encodeIndices(const int* indices, size_t n_indices, const std::vector<int>& lod_indices,
+			size_t n_vertices, std::vector<unsigned char>& out);
+
+	private:
+		Positions m_positions;
+		Normals m_normals;
+	};
+}
+
+#endif // __VERTEX_FORMAT_H__
@@ -0,0 +1,115 @@
+#include "EnvProbeClass.h"
+
+#include <algorithm>
+
+namespace SceneEditor {
+
+	namespace {
+
+		struct FormatInfo {
+			GLint internal_format;
+			GLenum format;
+			GLenum type;
+			size_t bytes;  // per texel
+			const char* name;
+		};
+
+		const FormatInfo s_formats[] = {
+			{ GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, "RGBA8" },
+			{ GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, 4, "R11G11B10F" },
+			{ GL_RGBA16F, GL_RGBA, GL_FLOAT, 8, "RGBA16F" }
+		};
+
+		// GL_DEPTH_COMPONENT24 is stored in 32 bits
+		const size_t s_depth_bytes = 4;
+	}
+
+	EnvProbePool::EnvProbePool() : m_size{ 512 }, m_format{ R11G11B10F }, m_capacity{ 8 } { }
+
+	void EnvProbePool::configure(int size, Format format, size_t capacity) {
+		free();
+		m_size = size;
+		m_format = format;
+		m_capacity = capacity;
+	}
+
+	int EnvProbePool::acquire() {
+		int slot = -1;
+		for (size_t i = 0; i < m_probes.size() && slot < 0; ++i) {
+			if (!m_used[i]) { slot = (int)i; }
+		}
+		if (slot < 0) {
+			if (m_probes.size() >= m_capacity) { return -1; }
+			m_probes.push_back(EnvProbe());
+			m_used.push_back(0);
+			allocate(m_probes.back());
+			slot = (int)m_probes.size() - 1;
+		}
+		m_used[slot] = 1;
+		EnvProbe& probe = m_probes[slot];
+		for (int face = 0; face < 6; ++face) {
+			probe.face_hash[face] = 0;
+			probe.face_latest[face] = 0;
+			probe.face_stale[face] = 0;
+		}
+		probe.drawn_faces = 0;
+		return slot;
+	}
+
+	void EnvProbePool::release(int probe) {
+		if (probe >= 0 && probe < (int)m_used.size()) {
+			m_used[probe] = 0;
+		}
+	}
+
+	void EnvProbePool::free() {
+		for (auto&& probe : m_probes) {
+			probe.fbo.free();
+			probe.color.free();
+			probe.depth.free();
+		}
+		m_probes.clear();
+		m_used.clear();
+	}
+
+	size_t EnvProbePool::inUse() const {
+		return (size_t)std::count(m_used.begin(), m_used.end(), 1);
+	}
+
+	size_t EnvProbePool::bytes() const {
+		size_t texels = (size_t)m_size * (size_t)m_size * 6;
+		return m_probes.size() * texels * (s_formats[m_format].bytes + s_depth_bytes);
+	}
+
+	const char* EnvProbePool::formatName() const {
+		return s_formats[m_format].name;
+	}
+
+	void EnvProbePool::allocate(EnvProbe& probe) {
+		const FormatInfo& info = s_formats[m_format];
+		probe.fbo.init();
+		probe.color.init();
+		probe.depth.init();
+		probe.layered = false;
+		Texture* textures[2] = { &probe.color, &probe.depth };
+		for (Texture* texture : textures) {
+			bool depth = texture == &probe.depth;
+			texture->bind(GL_TEXTURE_CUBE_MAP);
+			for (unsigned int i = 0; i < 6; ++i) {
+				if (depth) {
+					glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT24, m_size, m_size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+				}
+				else {
+					glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, info.internal_format, m_size, m_size, 0, info.format, info.type, NULL);
+				}
+			}
+			GLint filter = depth ? GL_NEAREST : GL_LINEAR;
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, filter);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, filter);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		}
+		check_gl_error();
+	}
+}
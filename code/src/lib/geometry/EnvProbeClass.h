@@ -0,0 +1,68 @@
+#ifndef __ENV_PROBE_H__
+#define __ENV_PROBE_H__
+
+#include "../../helper/HelperClass.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SceneEditor {
+
+	// Render target of one dynamic reflection: a color cube with its own depth cube
+	struct EnvProbe {
+		FrameBufferObject fbo;
+		Texture color;
+		Texture depth;  // a cube too, so the whole probe can be attached layered
+
+		// update scheduling, reset whenever the probe changes hands
+		uint64_t face_hash[6];    // what each face showed when it was last drawn
+		uint64_t face_latest[6];  // what each face should show as of the last frame
+		int face_stale[6];        // frames each face has been out of date
+		int drawn_faces;          // bit per face drawn at least once
+		bool layered;             // the whole cubes are attached, not a single face
+	};
+
+	/* [ENV PROBE POOL]
+	* Cube map targets for MODE8 objects. A probe is created the first time
+	* its slot is handed out and kept for reuse after release, so video
+	* memory follows the most reflective objects seen at once and never
+	* exceeds the capacity. configure() drops every probe.
+	*/
+	class EnvProbePool {
+	public:
+		enum Format {
+			RGBA8 = 0,
+			R11G11B10F = 1,
+			RGBA16F = 2
+		};
+
+		EnvProbePool();
+
+		// Face size in texels, color format and the most probes alive at once
+		void configure(int size, Format format, size_t capacity);
+		// A free slot, allocated if new, or -1 when every slot is taken. Its faces count as never drawn.
+		int acquire();
+		void release(int probe);
+		EnvProbe& operator[](int probe) { return m_probes[probe]; }
+		void free();
+
+		int size() const { return m_size; }
+		size_t capacity() const { return m_capacity; }
+		size_t inUse() const;
+		// Video memory of the allocated probes, color and depth
+		size_t bytes() const;
+		const char* formatName() const;
+
+	private:
+		void allocate(EnvProbe& probe);
+
+		std::vector<EnvProbe> m_probes;
+		std::vector<char> m_used;
+		int m_size;
+		Format m_format;
+		size_t m_capacity;
+	};
+}
+
+#endif // __ENV_PROBE_H__
@@ -1,6 +1,8 @@
 #include "GeometryClass.h"
 
 #include "../features/MeshClass.h"
+#include "../features/MeshOptimizerClass.h"
+#include "../features/MeshCacheClass.h"
 
 #include <glm/gtx/string_cast.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -8,11 +10,28 @@
 #include <limits>
 #include <algorithm>
 #include <cmath>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <tuple>
 
 namespace SceneEditor {
 
 	static bool red_shadow = false;
 
+	// side of each shadow cube face, in texels
+	static const int shadow_size = 1024;
+	// projected error, in pixels, a level may have at LOD bias 0
+	static const float lod_pixels = 1.f;
+	// shadow passes without a change before a caster counts as static
+	static const int shadow_settle_frames = 30;
+	// how much a probe filling the whole screen outranks one off screen, and a
+	// face whose view is changing right now one that changed earlier
+	static const float env_coverage_weight = 8.f;
+	static const float env_moving_weight = 2.f;
+	// world units a screen-space reflection is traced for
+	static const float ssr_distance = 10.f;
+
 	// Mesh Files: .off files
 	std::string obj_names[] = {
 		"data/cube.off", // cube.off
@@ -25,293 +44,318 @@ namespace SceneEditor {
 		"data/plane.off" //plane.off
 	};
 
-	Object::Object() : m_model{ 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f }
+	Object::Object() : proxy{ -1 }
+		, shadow_version{ ~0u }
+		, still_frames{ 0 }
+		, m_model{ 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f }
+		, m_version{ 0 }
 		, m_color{ 0.2f, 0.2f, 0.2f }
-		, m_mode{ MODE3 } {
-		m_vbo.init();
-		m_ebo.init();
-		m_nbo.init();
-
-		env_fbo.init();
-		env_texture.init();
-		configEnvMap();
+		, m_mode{ MODE3 }
+		, env_probe{ -1 } {
+		updateModelMatrix();
 	}
 
 	void Object::free() {
-		m_vbo.free();
-		m_ebo.free();
-		m_nbo.free();
+		m_mesh.reset();
+	}
 
-		env_fbo.free();
-		env_texture.free();
+	// instances of a draw into the faces of cube_faces, 1 outside a cube
+	static GLsizei cubeInstances(int cube_faces) {
+		GLsizei instances = 0;
+		for (int face = 0; face < 6; ++face) {
+			instances += (cube_faces >> face) & 1;
+		}
+		return std::max(instances, 1);
 	}
 
-	void Object::draw(std::vector<Program>& programs, Light& light, ViewControl& view_control, Texture& depth_texture, Texture& skybox_texture, bool isEnvMap) {
+	void Object::draw(std::vector<Program>& programs, Texture& depth_texture, Texture& skybox_texture, int lod,
+		const MeshletDraw* meshlets, int cube_faces) {
+		Program& wireframe = programs[cube_faces ? WIREFRAME_CUBE : WIREFRAME];
+		Program& flat = programs[cube_faces ? FLAT_CUBE : FLAT];
+		Program& phong = programs[cube_faces ? PHONG_CUBE : PHONG];
+		GLsizei instances = cubeInstances(cube_faces);
 		if (m_mode == MODE1) {
-			drawWireframe(programs[WIREFRAME], light, view_control, isEnvMap);
+			drawWireframe(wireframe, lod, meshlets, cube_faces);
 		}
 		else if (m_mode == MODE2) {
-			setFlatShading(programs[FLAT], view_control, isEnvMap);
-			setPhongLighting(programs[FLAT], light, view_control, depth_texture);
-			simpleDraw();
-			drawWireframe(programs[WIREFRAME], light, view_control, isEnvMap);
+			setFlatShading(flat);
+			setPhongLighting(flat, depth_texture);
+			setCubeFaces(flat, cube_faces);
+			simpleDraw(lod, meshlets, instances);
+			drawWireframe(wireframe, lod, meshlets, cube_faces);
 		}
 		else if (m_mode == MODE3) {
-			setPhongShading(programs[PHONG], view_control, isEnvMap);
-			setPhongLighting(programs[PHONG], light, view_control, depth_texture);
-			simpleDraw();
+			setPhongShading(phong);
+			setPhongLighting(phong, depth_texture);
+			setCubeFaces(phong, cube_faces);
+			simpleDraw(lod, meshlets, instances);
 		}
 		else if (m_mode == MODE4 || m_mode == MODE8) {
-			setPhongShading(programs[PHONG], view_control, isEnvMap);
-			setMirrorLighting(programs[PHONG], light, view_control, depth_texture, skybox_texture);
-			simpleDraw();
+			setPhongShading(phong);
+			setMirrorLighting(phong, depth_texture, skybox_texture);
+			setCubeFaces(phong, cube_faces);
+			simpleDraw(lod, meshlets, instances);
+		}
+		else if (m_mode == MODE9) {
+			setPhongShading(phong);
+			setScreenMirrorLighting(phong, depth_texture, skybox_texture);
+			setCubeFaces(phong, cube_faces);
+			simpleDraw(lod, meshlets, instances);
 		}
 		else if (m_mode == MODE5) {
-			setPhongShading(programs[PHONG], view_control, isEnvMap);
-			setRefractLighting(programs[PHONG], light, view_control, depth_texture, skybox_texture);
-			simpleDraw();
+			setPhongShading(phong);
+			setRefractLighting(phong, depth_texture, skybox_texture);
+			setCubeFaces(phong, cube_faces);
+			simpleDraw(lod, meshlets, instances);
 		}
 		else if (m_mode == MODE6) {
-			setFlatShading(programs[FLAT], view_control, isEnvMap);
-			setMirrorLighting(programs[FLAT], light, view_control, depth_texture, skybox_texture);
-			simpleDraw();
+			setFlatShading(flat);
+			setMirrorLighting(flat, depth_texture, skybox_texture);
+			setCubeFaces(flat, cube_faces);
+			simpleDraw(lod, meshlets, instances);
 		}
 		else if (m_mode == MODE7) {
-			setFlatShading(programs[FLAT], view_control, isEnvMap);
-			setRefractLighting(programs[FLAT], light, view_control, depth_texture, skybox_texture);
-			simpleDraw();
+			setFlatShading(flat);
+			setRefractLighting(flat, depth_texture, skybox_texture);
+			setCubeFaces(flat, cube_faces);
+			simpleDraw(lod, meshlets, instances);
 		}
 	}
 
-	void Object::drawEnvMapping(std::vector<Program>& programs, Light& light, ViewControl& view_control, Texture& depth_texture, Texture& skybox_texture, glm::mat4& envVPMatrix) {
-		m_envVPMatrix = envVPMatrix;
-		draw(programs, light, view_control, depth_texture, skybox_texture, true);
-	}
-
 	void Object::drawShadowMapping(Program& program) {
 		program.bind();
-		GLint uniModelMatrix = program.uniform("ModelMatrix");
-		glUniformMatrix4fv(uniModelMatrix, 1, GL_FALSE, glm::value_ptr(getModelMatrix()));
-
-		program.bindVertexAttribArray("position", m_vbo);
 		simpleDraw();
 	}
 
-	void Object::drawWireframe(Program& program, Light& light, ViewControl& view_control, bool isEnvMap) {
+	void Object::drawInstanced(std::vector<Program>& programs, Texture& depth_texture, Texture& skybox_texture,
+		MeshAsset& mesh, int lod, DisplayMode mode, VertexBufferObject& instances, size_t first, size_t count,
+		const MeshletDraw* meshlets) {
+		if (mode == MODE1 || mode == MODE2) {
+			Program& flat = programs[FLAT_INSTANCED];
+			if (mode == MODE2) {
+				StateCache::polygonMode(GL_FILL);
+				setInstancedShading(flat, mesh, instances, first);
+				setPhongLighting(flat, depth_texture);
+				instancedDraw(mesh, lod, count, meshlets);
+			}
+			Program& wireframe = programs[WIREFRAME_INSTANCED];
+			StateCache::polygonMode(GL_LINE);
+			setInstancedShading(wireframe, mesh, instances, first);
+			instancedDraw(mesh, lod, count, meshlets);
+		}
+		else if (mode == MODE3 || mode == MODE4 || mode == MODE5) {
+			Program& phong = programs[PHONG_INSTANCED];
+			StateCache::polygonMode(GL_FILL);
+			setInstancedShading(phong, mesh, instances, first);
+			if (mode == MODE3) {
+				setPhongLighting(phong, depth_texture);
+			}
+			else if (mode == MODE4) {
+				setMirrorLighting(phong, depth_texture, skybox_texture);
+			}
+			else {
+				setRefractLighting(phong, depth_texture, skybox_texture);
+			}
+			instancedDraw(mesh, lod, count, meshlets);
+		}
+		else if (mode == MODE6 || mode == MODE7) {
+			Program& flat = programs[FLAT_INSTANCED];
+			StateCache::polygonMode(GL_FILL);
+			setInstancedShading(flat, mesh, instances, first);
+			if (mode == MODE6) {
+				setMirrorLighting(flat, depth_texture, skybox_texture);
+			}
+			else {
+				setRefractLighting(flat, depth_texture, skybox_texture);
+			}
+			instancedDraw(mesh, lod, count, meshlets);
+		}
+	}
+
+	void Object::drawShadowMappingInstanced(Program& program, MeshAsset& mesh, int lod, VertexBufferObject& instances, size_t first, size_t count,
+		const MeshletDraw* meshlets) {
+		program.bind();
+		mesh.vao.bind();
+		program.bindInstanceAttribArray("InstanceModel", instances, 4, 4, sizeof(InstanceData),
+			first * sizeof(InstanceData) + offsetof(InstanceData, model));
+		instancedDraw(mesh, lod, count, meshlets);
+	}
+
+	void Object::setInstancedShading(Program& program, MeshAsset& mesh, VertexBufferObject& instances, size_t first) {
 		program.bind();
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		mesh.vao.bind();
+		size_t base = first * sizeof(InstanceData);
+		program.bindInstanceAttribArray("InstanceModel", instances, 4, 4, sizeof(InstanceData), base + offsetof(InstanceData, model));
+		program.bindInstanceAttribArray("InstanceNormal", instances, 3, 3, sizeof(InstanceData), base + offsetof(InstanceData, normal));
+		program.bindInstanceAttribArray("InstanceColor", instances, 3, 1, sizeof(InstanceData), base + offsetof(InstanceData, color));
+	}
 
-		glm::mat4 MVPMatrix, aspectRatioMatrix;
-		if (isEnvMap) {
-			MVPMatrix = m_envVPMatrix * getModelMatrix();
-			aspectRatioMatrix = glm::mat4(1.0f);
+	void Object::instancedDraw(MeshAsset& mesh, int lod, size_t count, const MeshletDraw* meshlets) {
+		// the instance arrays stay on the mesh VAO; the per-object programs
+		// have nothing at their locations, so they are never read there
+		if (meshlets) {
+			// a plain draw reads instance 0, which setInstancedShading put at the object
+			glMultiDrawElements(GL_TRIANGLES, meshlets->counts.data(), mesh.ebo.type, meshlets->offsets.data(), (GLsizei)meshlets->counts.size());
+			return;
 		}
-		else {
-			MVPMatrix = view_control.getProjMatrix() *
-				view_control.getViewMatrix() *
-				getModelMatrix();
-			aspectRatioMatrix = view_control.getAspectRatioMatrix();
+		glDrawElementsInstanced(GL_TRIANGLES, mesh.lodCount(lod), mesh.ebo.type, mesh.lodOffset(lod), (GLsizei)count);
+	}
+
+	InstanceData Object::getInstanceData() const {
+		InstanceData data;
+		// the GPU reads quantized positions, so decode them first
+		data.model = getModelMatrix() * m_mesh->decode;
+		data.normal = getNormalMatrix();
+		data.color = m_color;
+		data.object = -1.f;
+		return data;
+	}
+
+	ObjectBlock Object::getObjectBlock() const {
+		ObjectBlock block;
+		block.model = getModelMatrix() * m_mesh->decode;
+		glm::mat3 normal = getNormalMatrix();
+		for (int col = 0; col < 3; ++col) {
+			block.normal[col] = glm::vec4(normal[col], 0.f);
 		}
-		GLint uniColor = program.uniform("Color");
-		glUniform3fv(uniColor, 1, glm::value_ptr(m_color));
-		GLint uniMVP = program.uniform("MVPMatrix");
-		glUniformMatrix4fv(uniMVP, 1, GL_FALSE, glm::value_ptr(MVPMatrix));
-		GLint uniAR = program.uniform("AspectRatioMatrix");
-		glUniformMatrix4fv(uniAR, 1, GL_FALSE, glm::value_ptr(aspectRatioMatrix));
+		block.color = m_color;
+		block.pad = 0.f;
+		return block;
+	}
 
-		program.bindVertexAttribArray("position", m_vbo);
+	void Object::drawWireframe(Program& program, int lod, const MeshletDraw* meshlets, int cube_faces) {
+		program.bind();
+		StateCache::polygonMode(GL_LINE);
+		setCubeFaces(program, cube_faces);
+		simpleDraw(lod, meshlets, cubeInstances(cube_faces));
+	}
 
-		simpleDraw();
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	void Object::setCubeFaces(Program& program, int cube_faces) {
+		if (cube_faces) {
+			glUniform1i(program.uniform("faceMask"), cube_faces);
+		}
 	}
 
-	void Object::simpleDraw() {
-		m_ebo.bind();
-		glDrawElements(GL_TRIANGLES, m_ebo.cols, GL_UNSIGNED_INT, BUFFER_OFFSET(0));
+	void Object::simpleDraw(int lod, const MeshletDraw* meshlets, GLsizei instances) {
+		m_mesh->vao.bind();
+		if (meshlets && instances == 1) {
+			glMultiDrawElements(GL_TRIANGLES, meshlets->counts.data(), m_mesh->ebo.type, meshlets->offsets.data(), (GLsizei)meshlets->counts.size());
+		}
+		else if (meshlets) {
+			// GL 3.3 has no instanced multi-draw
+			for (size_t i = 0; i < meshlets->counts.size(); ++i) {
+				glDrawElementsInstanced(GL_TRIANGLES, meshlets->counts[i], m_mesh->ebo.type, meshlets->offsets[i], instances);
+			}
+		}
+		else if (instances == 1) {
+			glDrawElements(GL_TRIANGLES, m_mesh->lodCount(lod), m_mesh->ebo.type, m_mesh->lodOffset(lod));
+		}
+		else {
+			glDrawElementsInstanced(GL_TRIANGLES, m_mesh->lodCount(lod), m_mesh->ebo.type, m_mesh->lodOffset(lod), instances);
+		}
 	}
 
-	void Object::setMirrorLighting(Program& program, Light& light, ViewControl& view_control, Texture& depth_texture, Texture& skybox_texture) {
+	void Object::setMirrorLighting(Program& program, Texture& depth_texture, Texture& skybox_texture) {
 		program.bind();
-		GLint uniEyePosition = program.uniform("eyePosition");
-		glUniform3fv(uniEyePosition, 1, glm::value_ptr(view_control.getEyePosition()));
-		GLint uniLightPosition = program.uniform("lightPosition");
-		glUniform3fv(uniLightPosition, 1, glm::value_ptr(light.getPosition()));
-		glActiveTexture(GL_TEXTURE0);
+		StateCache::activeTexture(GL_TEXTURE0);
 		depth_texture.bind(GL_TEXTURE_CUBE_MAP);
-		glActiveTexture(GL_TEXTURE1);
+		StateCache::activeTexture(GL_TEXTURE1);
 		skybox_texture.bind(GL_TEXTURE_CUBE_MAP);
-		GLint uniRedShadow = program.uniform("red_shadow");
-		glUniform1i(uniRedShadow, red_shadow);
 
 		GLint uniStrategy = program.uniform("lighting_strategy");
 		glUniform1i(uniStrategy, 2);
 	}
 
-	void Object::setRefractLighting(Program& program, Light& light, ViewControl& view_control, Texture& depth_texture, Texture& skybox_texture) {
+	void Object::setScreenMirrorLighting(Program& program, Texture& depth_texture, Texture& skybox_texture) {
 		program.bind();
-		GLint uniEyePosition = program.uniform("eyePosition");
-		glUniform3fv(uniEyePosition, 1, glm::value_ptr(view_control.getEyePosition()));
-		GLint uniLightPosition = program.uniform("lightPosition");
-		glUniform3fv(uniLightPosition, 1, glm::value_ptr(light.getPosition()));
-		glActiveTexture(GL_TEXTURE0);
+		StateCache::activeTexture(GL_TEXTURE0);
 		depth_texture.bind(GL_TEXTURE_CUBE_MAP);
-		glActiveTexture(GL_TEXTURE1);
+		StateCache::activeTexture(GL_TEXTURE1);
 		skybox_texture.bind(GL_TEXTURE_CUBE_MAP);
-		GLint uniRedShadow = program.uniform("red_shadow");
-		glUniform1i(uniRedShadow, red_shadow);
 
 		GLint uniStrategy = program.uniform("lighting_strategy");
-		glUniform1i(uniStrategy, 3);
+		glUniform1i(uniStrategy, 4);
 	}
 
-	void Object::setPhongLighting(Program& program, Light& light, ViewControl& view_control, Texture& depth_texture) {
+	void Object::setRefractLighting(Program& program, Texture& depth_texture, Texture& skybox_texture) {
 		program.bind();
-
-		GLint uniColor = program.uniform("color");
-		glUniform3fv(uniColor, 1, glm::value_ptr(m_color));
-		GLint uniEyePosition = program.uniform("eyePosition");
-		glUniform3fv(uniEyePosition, 1, glm::value_ptr(view_control.getEyePosition()));
-		GLint uniLightPosition = program.uniform("lightPosition");
-		glUniform3fv(uniLightPosition, 1, glm::value_ptr(light.getPosition()));
-		GLint uniFarPlane = program.uniform("far_plane");
-		glUniform1f(uniFarPlane, view_control.viewfar());
-		glActiveTexture(GL_TEXTURE0);
+		StateCache::activeTexture(GL_TEXTURE0);
 		depth_texture.bind(GL_TEXTURE_CUBE_MAP);
-		GLint uniRedShadow = program.uniform("red_shadow");
-		glUniform1i(uniRedShadow, red_shadow);
+		StateCache::activeTexture(GL_TEXTURE1);
+		skybox_texture.bind(GL_TEXTURE_CUBE_MAP);
 
 		GLint uniStrategy = program.uniform("lighting_strategy");
-		glUniform1i(uniStrategy, 1);
+		glUniform1i(uniStrategy, 3);
 	}
 
-	void Object::setFlatShading(Program& program, ViewControl& view_control, bool isEnvMap) {
+	void Object::setPhongLighting(Program& program, Texture& depth_texture) {
 		program.bind();
+		StateCache::activeTexture(GL_TEXTURE0);
+		depth_texture.bind(GL_TEXTURE_CUBE_MAP);
 
-		glm::mat4 MVPMatrix, aspectRatioMatrix;
-		if (isEnvMap) {
-			MVPMatrix = m_envVPMatrix * getModelMatrix();
-			aspectRatioMatrix = glm::mat4(1.0f);
-		}
-		else {
-			MVPMatrix = view_control.getProjMatrix() *
-				view_control.getViewMatrix() *
-				getModelMatrix();
-			aspectRatioMatrix = view_control.getAspectRatioMatrix();
-		}
-		GLint uniMVPMatrix = program.uniform("MVPMatrix");
-		glUniformMatrix4fv(uniMVPMatrix, 1, GL_FALSE, glm::value_ptr(MVPMatrix));
-		GLint uniAR = program.uniform("AspectRatioMatrix");
-		glUniformMatrix4fv(uniAR, 1, GL_FALSE, glm::value_ptr(aspectRatioMatrix));
-		GLint uniModelMatrix = program.uniform("ModelMatrix");
-		glUniformMatrix4fv(uniModelMatrix, 1, GL_FALSE, glm::value_ptr(getModelMatrix()));
-
-		program.bindVertexAttribArray("position", m_vbo);
+		GLint uniStrategy = program.uniform("lighting_strategy");
+		glUniform1i(uniStrategy, 1);
 	}
 
-	void Object::setPhongShading(Program& program, ViewControl& view_control, bool isEnvMap) {
+	void Object::setFlatShading(Program& program) {
 		program.bind();
+		StateCache::polygonMode(GL_FILL);
+	}
 
-		glm::mat4 MVPMatrix, aspectRatioMatrix;
-		if (isEnvMap) {
-			MVPMatrix = m_envVPMatrix * getModelMatrix();
-			aspectRatioMatrix = glm::mat4(1.0f);
-		}
-		else {
-			MVPMatrix = view_control.getProjMatrix() *
-				view_control.getViewMatrix() *
-				getModelMatrix();
-			aspectRatioMatrix = view_control.getAspectRatioMatrix();
-		}
-		GLint uniMVPMatrix = program.uniform("MVPMatrix");
-		glUniformMatrix4fv(uniMVPMatrix, 1, GL_FALSE, glm::value_ptr(MVPMatrix));
-		GLint uniAR = program.uniform("AspectRatioMatrix");
-		glUniformMatrix4fv(uniAR, 1, GL_FALSE, glm::value_ptr(aspectRatioMatrix));
-		GLint uniModelMatrix = program.uniform("ModelMatrix");
-		glUniformMatrix4fv(uniModelMatrix, 1, GL_FALSE, glm::value_ptr(getModelMatrix()));
-		GLint uniNormalMatrix = program.uniform("NormalMatrix");
-		glUniformMatrix3fv(uniNormalMatrix, 1, GL_FALSE, glm::value_ptr(getNormalMatrix()));
-
-		program.bindVertexAttribArray("position", m_vbo);
-		program.bindVertexAttribArray("vertex_normal", m_nbo);
+	void Object::setPhongShading(Program& program) {
+		program.bind();
+		StateCache::polygonMode(GL_FILL);
 	}
 
 	void Object::loadFromOffFile(const std::string& path) {
-		auto p = Mesh::read(path);
-		m_vertices = p.first;
-		m_indices = p.second;
-
-		int n = m_vertices.size();
-		m_vertex_normals = std::vector<glm::vec3>(n, glm::vec3(0.f));
-		std::vector<int> count(n, 0);
-		for (int i = 0; i < m_indices.size(); i += 3) {
-			int index_a = m_indices[i];
-			int index_b = m_indices[i + 1];
-			int index_c = m_indices[i + 2];
-
-			glm::vec3 a = m_vertices[index_a];
-			glm::vec3 b = m_vertices[index_b];
-			glm::vec3 c = m_vertices[index_c];
+		m_mesh = std::make_shared<MeshAsset>();
+		m_mesh->path = path;
+		Mesh::read(path, m_mesh->vertices, m_mesh->indices);
+		Mesh::CleanStats cleanup = Mesh::clean(m_mesh->vertices, m_mesh->indices);
+		printf("[SYSTEM INFO::MESH LOADER] %s || CLEANUP: %zu WELDED, %zu DEGENERATE, %zu DUPLICATE, %zu UNREFERENCED (%zu -> %zu VERTICES) IN %.3f ms\n",
+			path.c_str(), cleanup.welded, cleanup.degenerate, cleanup.duplicate, cleanup.unreferenced,
+			cleanup.vertices_before, cleanup.vertices_after, cleanup.ms);
+		Mesh::computeNormals(m_mesh->vertices, m_mesh->indices, m_mesh->normals);
+		MeshOptimizer::Stats stats = MeshOptimizer::optimize(m_mesh->vertices, m_mesh->normals, m_mesh->indices);
+		printf("[SYSTEM INFO::MESH LOADER] %s || ACMR %.3f -> %.3f (CACHE %d), %zu CLUSTERS IN %.3f ms\n",
+			path.c_str(), stats.acmr_before, stats.acmr_after, MeshOptimizer::s_cache_size, stats.clusters, stats.ms);
+	}
 
-			glm::vec3 normal = glm::normalize(glm::cross(b - a, c - b));
-			m_vertex_normals[index_a] += normal;
-			m_vertex_normals[index_b] += normal;
-			m_vertex_normals[index_c] += normal;
-			count[index_a] += 1;
-			count[index_b] += 1;
-			count[index_c] += 1;
-		}
-		for (int i = 0; i < n; ++i) {
-			if (count[i] != 0) {
-				m_vertex_normals[i] /= count[i];
-			}
-		}
+	void Object::setMesh(const MeshAsset::ptr& mesh) {
+		m_mesh = mesh;
+		++m_version;
 	}
 
 	void Object::update() {
-		m_vbo.update(m_vertices);
-		m_ebo.update(m_indices);
-		m_nbo.update(m_vertex_normals);
-	}
-
-	void Object::configEnvMap() {
-		env_texture.bind(GL_TEXTURE_CUBE_MAP);
-		for (unsigned int i = 0; i < 6; ++i) {
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-				0,
-				GL_RGBA,
-				s_env_width,
-				s_env_height,
-				0,
-				GL_RGBA,
-				GL_FLOAT,
-				NULL);
-		}
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-		env_fbo.attach_color_texture(env_texture);
+		++m_version;
+		m_mesh->computeBounds();
+		m_mesh->bvh.build(m_mesh->vertices, m_mesh->indices);
+		m_mesh->update();
 	}
 
 	void Object::setDisplayMode(DisplayMode mode) { m_mode = mode; }
 
-	Object::DisplayMode Object::getDisplayMode() { return m_mode; }
+	Object::DisplayMode Object::getDisplayMode() const { return m_mode; }
 
 
 	void Object::translate(float x, float y, float z) {
 		m_model[0] += x;
 		m_model[1] += y;
 		m_model[2] += z;
+		updateModelMatrix();
 	}
 
 	void Object::rotate(float x, float y, float z) {
 		m_model[3] += x;
 		m_model[4] += y;
 		m_model[5] += z;
+		updateModelMatrix();
 	}
 
-	void Object::scale(float change) { m_model[6] += change; }
+	void Object::scale(float change) {
+		m_model[6] += change;
+		updateModelMatrix();
+	}
 
 	void Object::color(glm::vec3& color) {
 		m_color = { color[0], color[1], color[2] };
@@ -322,39 +366,25 @@ namespace SceneEditor {
 	}
 
 	void Object::unitize() {
-		float min_x, min_y, min_z, max_x, max_y, max_z;
-		min_x = min_y = min_z = std::numeric_limits<float>::max();
-		max_x = max_y = max_z = std::numeric_limits<float>::min();
-		for (int i = 0; i < m_vertices.size(); ++i) {
-			min_x = std::min(min_x, m_vertices[i][0]);
-			min_y = std::min(min_y, m_vertices[i][1]);
-			min_z = std::min(min_z, m_vertices[i][2]);
-
-			max_x = std::max(max_x, m_vertices[i][0]);
-			max_y = std::max(max_y, m_vertices[i][1]);
-			max_z = std::max(max_z, m_vertices[i][2]);
-		}
-		float scale = std::max({ max_x - min_x, max_y - min_y, max_z - min_z });
-		for (int i = 0; i < m_vertices.size(); ++i) {
-			m_vertices[i][0] -= (min_x + max_x) / 2;
-			m_vertices[i][1] -= (min_y + max_y) / 2;
-			m_vertices[i][2] -= (min_z + max_z) / 2;
-			if (scale != 0.f) {
-				m_vertices[i][0] /= scale;
-				m_vertices[i][1] /= scale;
-				m_vertices[i][2] /= scale;
-			}
-		}
+		Mesh::unitize(m_mesh->vertices);
 	}
 
 	std::pair<bool, float> Object::intersectRay(const glm::vec3& e, const glm::vec3& d, float vnear, float vfar) const {
+		if (!m_mesh->bvh.empty()) {
+			// the model matrix is affine, so t along the object-space ray is t along the world ray
+			glm::vec3 local_e = glm::vec3(m_inverse_model_matrix * glm::vec4(e, 1.f));
+			glm::vec3 local_d = glm::vec3(m_inverse_model_matrix * glm::vec4(d, 0.f));
+			return m_mesh->bvh.intersect(local_e, local_d, vnear, vfar);
+		}
+		const std::vector<glm::vec3>& vertices = m_mesh->vertices;
+		const std::vector<int>& indices = m_mesh->indices;
 		float min_t = std::numeric_limits<float>::max();
 		bool intersect = false;
-		glm::mat4 transform = getModelMatrix();
-		for (int i = 0; i < m_indices.size(); i += 3) {
-			glm::vec3 a = glm::vec3(transform * glm::vec4(m_vertices[m_indices[i]], 1.f));
-			glm::vec3 b = glm::vec3(transform * glm::vec4(m_vertices[m_indices[i + 1]], 1.f));
-			glm::vec3 c = glm::vec3(transform * glm::vec4(m_vertices[m_indices[i + 2]], 1.f));
+		const glm::mat4& transform = m_model_matrix;
+		for (int i = 0; i < indices.size(); i += 3) {
+			glm::vec3 a = glm::vec3(transform * glm::vec4(vertices[indices[i]], 1.f));
+			glm::vec3 b = glm::vec3(transform * glm::vec4(vertices[indices[i + 1]], 1.f));
+			glm::vec3 c = glm::vec3(transform * glm::vec4(vertices[indices[i + 2]], 1.f));
 			// a,b,c,e,d are al world coordinate
 			auto p = intersectTriangle(a, b, c, e, d, vnear, vfar);
 			if (p.first) {
@@ -366,6 +396,10 @@ namespace SceneEditor {
 	}
 
 	glm::mat4 Object::getModelMatrix() const {
+		return m_model_matrix;
+	}
+
+	void Object::updateModelMatrix() {
 		float translate_x = m_model[0];
 		float translate_y = m_model[1];
 		float translate_z = m_model[2];
@@ -381,24 +415,44 @@ namespace SceneEditor {
 			glm::rotate(glm::mat4(1.f), glm::radians(rotate_z), glm::vec3(0.f, 0.f, 1.f)) *
 			glm::scale(glm::mat4(1.f), glm::vec3(scale)) *
 			glm::translate(glm::mat4(1.f), barycentre);
-		return res;
+		m_model_matrix = res;
+		m_inverse_model_matrix = glm::inverse(res);
+		m_bounds_dirty = true;
+		++m_version;
+	}
+
+	void Object::getWorldBounds(glm::vec3& lo, glm::vec3& hi) const {
+		// Arvo: transform the box by accumulating the min/max of each matrix term
+		glm::vec3 center = glm::vec3(m_model_matrix[3]);
+		lo = center;
+		hi = center;
+		for (int col = 0; col < 3; ++col) {
+			glm::vec3 a = glm::vec3(m_model_matrix[col]) * m_mesh->bounds_min[col];
+			glm::vec3 b = glm::vec3(m_model_matrix[col]) * m_mesh->bounds_max[col];
+			lo += glm::min(a, b);
+			hi += glm::max(a, b);
+		}
 	}
 
 	glm::mat3 Object::getNormalMatrix() const {
-		return glm::mat3(glm::transpose(glm::inverse(getModelMatrix())));
+		return glm::mat3(glm::transpose(m_inverse_model_matrix));
+	}
+
+	glm::mat4 Object::getEnvProjMatrix() const {
+		// probe faces are square
+		return glm::perspective(glm::radians(90.f), 1.f, 0.5f * m_model[6], 20.f);
 	}
 
-	std::vector<glm::mat4> Object::getEnvVPMatrices() const {
-		glm::mat4 envProj = glm::perspective(glm::radians(90.f), (float)s_env_width / (float)s_env_height, 0.5f * m_model[6], 20.f);
-		std::vector<glm::mat4> envVPMatrices;
+	std::vector<glm::mat4> Object::getEnvViewMatrices() const {
+		std::vector<glm::mat4> envViewMatrices;
 		glm::vec3 objPos = { m_model[0], m_model[1], m_model[2] };
-		envVPMatrices.push_back(envProj * glm::lookAt(objPos, objPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-		envVPMatrices.push_back(envProj * glm::lookAt(objPos, objPos + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-		envVPMatrices.push_back(envProj * glm::lookAt(objPos, objPos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
-		envVPMatrices.push_back(envProj * glm::lookAt(objPos, objPos + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)));
-		envVPMatrices.push_back(envProj * glm::lookAt(objPos, objPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-		envVPMatrices.push_back(envProj * glm::lookAt(objPos, objPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-		return envVPMatrices;
+		envViewMatrices.push_back(glm::lookAt(objPos, objPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
+		envViewMatrices.push_back(glm::lookAt(objPos, objPos + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
+		envViewMatrices.push_back(glm::lookAt(objPos, objPos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+		envViewMatrices.push_back(glm::lookAt(objPos, objPos + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)));
+		envViewMatrices.push_back(glm::lookAt(objPos, objPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
+		envViewMatrices.push_back(glm::lookAt(objPos, objPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
+		return envViewMatrices;
 	}
 
 	std::pair<bool, float> Object::intersectTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
@@ -413,108 +467,782 @@ namespace SceneEditor {
 		return { true, t };
 	}
 
-	Geometry::Geometry() : m_light{ 1.f, 1.f, 1.f } { }
+	static_assert(sizeof(FrameBlock) == 672, "FrameBlock must match the std140 Frame block");
+	static_assert(sizeof(ObjectBlock) == 128, "ObjectBlock must match the std140 Object block");
+
+	Geometry::Geometry() : m_frame(), m_light{ 1.f, 1.f, 1.f }, m_gpu_picking{ false }, m_lod_bias{ 0.f, 1.f, 1.f }, m_submit_us{ 0.0 }, m_submitted{ 0 },
+		m_meshlets_tested{ 0 }, m_meshlets_drawn{ 0 }, m_vertex_layer{ false }, m_layered_env{ false }, m_ssr{ false }, m_shadow_triangles{ 0 },
+		m_shadow_caching{ SHADOW_ON_CHANGE }, m_shadow_dirty{ true }, m_shadow_far{ 0.f }, m_shadow_updates{ 0 }, m_shadow_bakes{ 0 }, m_shadow_generation{ 0 },
+		m_env_face_budget{ 0 }, m_env_faces_drawn{ 0 }, m_env_faces_deferred{ 0 }, m_env_faces_skipped{ 0 }, m_env_max_stale{ 0 } { }
 
 	void Geometry::init() {
-		m_vao.init();
+		m_box_vao.init();
 		m_depth_fbo.init();
 		m_depth_texture.init();
+		m_static_fbo.init();
+		m_static_texture.init();
+		m_copy_read_fbo.init();
+		m_copy_draw_fbo.init();
+		m_pick.init();
+		m_reflection.init();
+		m_frame_ubo.init();
+		m_object_ubo.init();
+		ObjectBlock block = ObjectBlock();
+		m_frame_ubo.update(&m_frame, sizeof(FrameBlock), 1, 1);
+		m_object_ubo.update(&block, sizeof(ObjectBlock), 1, 1);
+		m_frame_ubo.bindBase(FRAME_BLOCK);
+		m_object_ubo.bindBase(OBJECT_BLOCK);
+
+		// unitized meshes always land inside this box
+		std::vector<glm::vec3> corners;
+		for (int i = 0; i < 8; ++i) {
+			corners.push_back(glm::vec3(i & 1 ? .5f : -.5f, i & 2 ? .5f : -.5f, i & 4 ? .5f : -.5f));
+		}
+		std::vector<int> edges = {
+			0, 1, 2, 3, 4, 5, 6, 7,
+			0, 2, 1, 3, 4, 6, 5, 7,
+			0, 4, 1, 5, 2, 6, 3, 7
+		};
+		m_instance_vbo.init();
+		m_shadow_instance_vbo.init();
+		m_box_vbo.init();
+		m_box_ebo.init();
+		m_box_vao.bind();
+		m_box_vbo.update(corners);
+		m_box_ebo.update(edges);
+		m_box_vao.attribute(POSITION_ATTRIB, m_box_vbo);
+
+		MeshRegistry& registry = m_registry;
+		m_importer.setLookup([&registry](const std::string& path, uint64_t source_hash) {
+			return registry.contains(path, source_hash);
+		});
+		m_importer.setVertexFormat(MeshAsset::s_format);
+		m_importer.start();
+		printf("[SYSTEM INFO::PICKING] RAY KERNEL || %s\n", RayKernel::isa());
 	}
 
 	void Geometry::free() {
-		m_vao.free();
+		m_importer.stop();
+		m_instance_vbo.free();
+		m_shadow_instance_vbo.free();
+		m_box_vbo.free();
+		m_box_ebo.free();
+		m_box_vao.free();
+		m_frame_ubo.free();
+		m_object_ubo.free();
 		for (auto&& obj : m_objs) {
 			obj.free();
 		}
+		m_objs.clear();
+		m_tree.clear();
 		m_depth_fbo.free();
 		m_depth_texture.free();
-	}
-
-	void Geometry::bind() {
-		m_vao.bind();
+		m_static_fbo.free();
+		m_static_texture.free();
+		m_copy_read_fbo.free();
+		m_copy_draw_fbo.free();
+		m_probes.free();
+		m_pick.free();
+		m_reflection.free();
 	}
 
 	void Geometry::configShadowMap() {
-		m_depth_texture.bind(GL_TEXTURE_CUBE_MAP);
-		for (unsigned int i = 0; i < 6; ++i) {
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, 1024, 1024, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-		}
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		// the static cube is only drawn into and copied from, never sampled
+		Texture* textures[2] = { &m_depth_texture, &m_static_texture };
+		for (Texture* texture : textures) {
+			texture->bind(GL_TEXTURE_CUBE_MAP);
+			for (unsigned int i = 0; i < 6; ++i) {
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, shadow_size, shadow_size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+			}
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		}
 		m_depth_fbo.attach_depth_texture(m_depth_texture);
+		m_static_fbo.attach_depth_texture(m_static_texture);
+		m_shadow_dirty = true;
 	}
 
-	void Geometry::getShadowTexture(Program& program, ViewControl& view_control) {
-		m_depth_fbo.bind();
-		glClear(GL_DEPTH_BUFFER_BIT);
-		program.bind();
+	void Geometry::updateFrame(ViewControl& view_control) {
 		std::vector<glm::mat4> shadowMatrices = view_control.getShadowMatrices(m_light.getPosition());
-		for (int i = 0; i < 6; ++i) {
-			GLint uniShadowMatrix_i = program.uniform("shadowMatrices[" + std::to_string(i) + "]");
-			glUniformMatrix4fv(uniShadowMatrix_i, 1, GL_FALSE, glm::value_ptr(shadowMatrices[i]));
-		}
-		GLint uniFarPlane = program.uniform("far_plane");
-		glUniform1f(uniFarPlane, view_control.viewfar());
-		GLint uniLightPosition = program.uniform("lightPosition");
-		glUniform3fv(uniLightPosition, 1, glm::value_ptr(m_light.getPosition()));
+		std::copy(shadowMatrices.begin(), shadowMatrices.end(), m_frame.shadow);
+		m_frame.eye = view_control.getEyePosition();
+		m_frame.far_plane = view_control.viewfar();
+		m_frame.light = m_light.getPosition();
+		m_frame.red_shadow = red_shadow;
+		uploadFrame(view_control.getViewMatrix(), view_control.getProjMatrix(), view_control.getAspectRatioMatrix());
+	}
+
+	void Geometry::uploadFrame(const glm::mat4& view, const glm::mat4& proj, const glm::mat4& aspect_ratio) {
+		m_frame.view = view;
+		m_frame.proj = proj;
+		m_frame.view_proj = proj * view;
+		m_frame.aspect_ratio = aspect_ratio;
+		m_frame_ubo.update(&m_frame, sizeof(FrameBlock), 1, 1);
+	}
+
+	void Geometry::drawObject(std::vector<Program>& programs, Object& obj, Texture& skybox_texture, int lod,
+		const MeshletDraw* meshlets, int cube_faces) {
+		ObjectBlock block = obj.getObjectBlock();
+		m_object_ubo.update(&block, sizeof(ObjectBlock), 1, 1);
+		obj.draw(programs, m_depth_texture, skybox_texture, lod, meshlets, cube_faces);
+	}
+
+	void Geometry::setLodBias(LodPass pass, float bias) {
+		m_lod_bias[pass] = bias;
+		m_shadow_dirty = true;
+	}
+
+	void Geometry::configEnvProbes(int size, EnvProbePool::Format format, size_t capacity) {
+		m_probes.configure(size, format, capacity);
 		for (auto&& obj : m_objs) {
-			obj.drawShadowMapping(program);
+			obj.env_probe = -1;
+		}
+	}
+
+	void Geometry::setShadowCaching(ShadowCaching caching) {
+		m_shadow_caching = caching;
+		m_shadow_dirty = true;
+	}
+
+	Geometry::LodView Geometry::lodView(LodPass pass, const glm::vec3& eye, float focal, float height, bool orthographic) const {
+		LodView view;
+		view.eye = eye;
+		view.pixels_per_unit = focal * height * .5f;
+		view.orthographic = orthographic;
+		view.bias = m_lod_bias[pass];
+		return view;
+	}
+
+	int Geometry::selectLod(const Object& obj, const LodView& view) const {
+		const std::vector<MeshLod>& lods = obj.getMesh()->lods;
+		if (lods.size() < 2) { return 0; }
+		// errors are in mesh units; the largest axis scale takes them to world units
+		glm::mat4 model = obj.getModelMatrix();
+		float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+		float pixels = view.pixels_per_unit * scale;
+		if (!view.orthographic) {
+			// from the nearest point of the bounds; an eye inside them gets the full mesh
+			glm::vec3 lo, hi;
+			obj.getWorldBounds(lo, hi);
+			float distance = glm::length(glm::max(glm::max(lo - view.eye, view.eye - hi), glm::vec3(0.f)));
+			if (distance <= 0.f) { return 0; }
+			pixels /= distance;
+		}
+		float allowed = lod_pixels * std::exp2(view.bias);
+		for (int lod = (int)lods.size() - 1; lod > 0; --lod) {
+			if (lods[lod].error * pixels <= allowed) { return lod; }
+		}
+		return 0;
+	}
+
+	bool Geometry::cullMeshlets(const Object& obj, int lod, const CullView& view, bool filled, MeshletDraw& draw) {
+		draw.counts.clear();
+		draw.offsets.clear();
+		const MeshAsset& mesh = *obj.getMesh();
+		const MeshLod& level = mesh.lods[lod];
+		if (level.meshlet_count == 0) { return false; }
+		// wireframe shows the back edges, and an open mesh shows its back faces
+		bool cones = view.cones && filled && mesh.closed;
+		std::vector<int> kept;
+		Meshlets::cull(mesh.meshlets.data() + level.first_meshlet, level.meshlet_count, obj.getModelMatrix(),
+			view.volumes, view.eye, cones, kept);
+		for (int m : kept) {
+			const Meshlet& meshlet = mesh.meshlets[level.first_meshlet + m];
+			draw.counts.push_back((GLsizei)meshlet.count);
+			draw.offsets.push_back(mesh.indexOffset(meshlet.first));
+		}
+		m_meshlets_tested += level.meshlet_count;
+		m_meshlets_drawn += kept.size();
+		return true;
+	}
+
+	void Geometry::getShadowTexture(std::vector<Program>& programs) {
+		// the light matrices also move with the camera's near and far planes
+		bool light_changed = m_shadow_dirty || m_shadow_far != m_frame.far_plane
+			|| !std::equal(m_frame.shadow, m_frame.shadow + 6, m_shadow_faces);
+		std::copy(m_frame.shadow, m_frame.shadow + 6, m_shadow_faces);
+		m_shadow_far = m_frame.far_plane;
+		m_shadow_dirty = false;
+
+		// a caster is dynamic until it has been still for shadow_settle_frames;
+		// the static set changes when one starts moving or settles
+		bool moved = false;
+		bool static_changed = light_changed;
+		std::vector<char> dynamic(m_objs.size(), 0);
+		for (size_t i = 0; i < m_objs.size(); ++i) {
+			Object& obj = m_objs[i];
+			if (obj.version() != obj.shadow_version) {
+				obj.shadow_version = obj.version();
+				static_changed |= obj.still_frames >= shadow_settle_frames;
+				obj.still_frames = 0;
+				moved = true;
+			}
+			else if (obj.still_frames < shadow_settle_frames && ++obj.still_frames == shadow_settle_frames) {
+				static_changed = true;
+			}
+			dynamic[i] = obj.still_frames < shadow_settle_frames;
+		}
+
+		if (m_shadow_caching == SHADOW_STATIC_SPLIT) {
+			if (!static_changed && !moved) { return; }
+			if (static_changed) {
+				std::vector<char> settled(m_objs.size());
+				for (size_t i = 0; i < m_objs.size(); ++i) {
+					settled[i] = !dynamic[i];
+				}
+				m_static_fbo.bind();
+				glClear(GL_DEPTH_BUFFER_BIT);
+				drawShadowCasters(programs, &settled);
+				++m_shadow_bakes;
+			}
+			FrameBufferObject::copy_depth_cube(m_copy_read_fbo, m_copy_draw_fbo, m_static_texture, m_depth_texture, shadow_size);
+			m_depth_fbo.bind();
+			if (std::find(dynamic.begin(), dynamic.end(), 1) != dynamic.end()) {
+				drawShadowCasters(programs, &dynamic);
+			}
+		}
+		else {
+			if (m_shadow_caching == SHADOW_ON_CHANGE && !light_changed && !moved) { return; }
+			m_depth_fbo.bind();
+			glClear(GL_DEPTH_BUFFER_BIT);
+			drawShadowCasters(programs, nullptr);
 		}
 		m_depth_fbo.unbind();
+		++m_shadow_updates;
+		// a redraw with no light change and nothing moved (SHADOW_EVERY_FRAME) gives the same cube
+		if (light_changed || moved) { ++m_shadow_generation; }
+	}
+
+	void Geometry::drawShadowCasters(std::vector<Program>& programs, const std::vector<char>* casters) {
+		Program& program = programs[m_vertex_layer ? SHADOW_LAYERED : SHADOW_INSTANCED];
+		program.bind();
+		StateCache::polygonMode(GL_FILL);
+
+		// which of the six light frusta each object touches, one bit per face
+		std::vector<char> faces(m_objs.size(), 0);
+		for (int face = 0; face < 6; ++face) {
+			m_tree.queryFrustum(m_frame.shadow[face], [&faces, face](int index) { faces[index] |= (char)(1 << face); });
+		}
+		for (size_t i = 0; casters && i < m_objs.size(); ++i) {
+			if (!(*casters)[i]) { faces[i] = 0; }
+		}
+
+		// one level per object for all six faces, as seen from the light
+		LodView lod_view = lodView(SHADOW_LOD, m_light.getPosition(), 1.f, (float)shadow_size);
+		CullView cull_view;
+		cull_view.eye = m_light.getPosition();
+		cull_view.cones = true;
+		std::vector<InstanceData> instances;
+		std::vector<InstanceGroup> groups;
+		std::vector<MeshletDraw> draws;
+		std::vector<int> group_faces;
+		if (m_vertex_layer) {
+			// each face gets only the objects and meshlets in its own frustum
+			std::vector<char> visible(m_objs.size());
+			std::vector<InstanceData> face_instances;
+			std::vector<InstanceGroup> face_groups;
+			std::vector<MeshletDraw> face_draws;
+			cull_view.volumes.resize(1);
+			for (int face = 0; face < 6; ++face) {
+				for (size_t i = 0; i < m_objs.size(); ++i) {
+					visible[i] = (faces[i] >> face) & 1;
+				}
+				cull_view.volumes[0] = m_frame.shadow[face];
+				buildInstances(true, &visible, &lod_view, &cull_view, face_instances, face_groups, face_draws);
+				for (auto&& group : face_groups) {
+					group.first += instances.size();
+					if (group.draw >= 0) { group.draw += (int)draws.size(); }
+					groups.push_back(group);
+					group_faces.push_back(face);
+				}
+				instances.insert(instances.end(), face_instances.begin(), face_instances.end());
+				draws.insert(draws.end(), face_draws.begin(), face_draws.end());
+			}
+		}
+		else {
+			// the geometry shader sends every triangle to all six faces, so anything any face sees stays
+			for (auto&& face : faces) {
+				face = face != 0;
+			}
+			cull_view.volumes.assign(m_frame.shadow, m_frame.shadow + 6);
+			buildInstances(true, &faces, &lod_view, &cull_view, instances, groups, draws);
+		}
+		if (!instances.empty()) {
+			m_shadow_instance_vbo.update(instances);
+		}
+		GLint uniFace = program.uniform("shadowFace");
+		int current_face = -1;
+		for (size_t g = 0; g < groups.size(); ++g) {
+			const InstanceGroup& group = groups[g];
+			const MeshletDraw* meshlets = group.draw >= 0 ? &draws[group.draw] : nullptr;
+			if (m_vertex_layer && group_faces[g] != current_face) {
+				current_face = group_faces[g];
+				glUniform1i(uniFace, current_face);
+			}
+			Object::drawShadowMappingInstanced(program, *group.mesh, group.lod, m_shadow_instance_vbo, group.first, group.count, meshlets);
+
+			size_t n_indices = 0;
+			if (meshlets) {
+				for (GLsizei count : meshlets->counts) { n_indices += count; }
+			}
+			else {
+				n_indices = group.mesh->lodCount(group.lod);
+			}
+			m_shadow_triangles += n_indices / 3 * group.count * (m_vertex_layer ? 1 : 6);
+		}
+	}
+
+	void Geometry::assignEnvProbes() {
+		// releases first, so a probe can pass from one object to another in the same frame
+		for (auto&& obj : m_objs) {
+			if (obj.env_probe >= 0 && obj.getDisplayMode() != Object::MODE8) {
+				m_probes.release(obj.env_probe);
+				obj.env_probe = -1;
+			}
+		}
+		for (auto&& obj : m_objs) {
+			if (obj.env_probe >= 0 || obj.getDisplayMode() != Object::MODE8) { continue; }
+			size_t allocated = m_probes.bytes();
+			obj.env_probe = m_probes.acquire();
+			if (obj.env_probe < 0) {
+				// stays on the static skybox until a probe comes free
+				continue;
+			}
+			if (m_probes.bytes() != allocated) {
+				printf("[SYSTEM INFO::ENV PROBE] %dx%d %s || %zu/%zu IN USE, %.1f MB\n", m_probes.size(), m_probes.size(),
+					m_probes.formatName(), m_probes.inUse(), m_probes.capacity(), m_probes.bytes() / (1024.0 * 1024.0));
+			}
+		}
+	}
+
+	uint64_t Geometry::envFaceHash(int obj, int face, const glm::mat4& view_proj, std::vector<int>& objects) const {
+		objects.clear();
+		m_tree.queryFrustum(view_proj, [&objects, obj](int index) {
+			if (index != obj) { objects.push_back(index); }
+		});
+		std::sort(objects.begin(), objects.end());
+
+		// words, not a struct, so no padding bytes reach the hash
+		std::vector<uint32_t> words;
+		auto add = [&words](const glm::vec3& v) {
+			uint32_t bits[3];
+			std::memcpy(bits, &v[0], sizeof(bits));
+			words.insert(words.end(), bits, bits + 3);
+		};
+		words.push_back((uint32_t)face);
+		words.push_back(m_objs[obj].version());
+		words.push_back((uint32_t)red_shadow);
+		// shadows cast by objects outside the face still change what it shows
+		words.push_back(m_shadow_generation);
+		add(m_light.getPosition());
+		for (int index : objects) {
+			const Object& other = m_objs[index];
+			words.push_back((uint32_t)index);
+			words.push_back(other.version());
+			words.push_back((uint32_t)other.getDisplayMode());
+			add(other.getColor());
+		}
+		return MeshCache::hash((const char*)words.data(), words.size() * sizeof(uint32_t));
 	}
 
 	void Geometry::getEnvTexture(std::vector<Program>& programs, ViewControl& view_control, Skybox& skybox) {
 		Texture skybox_texture = skybox.getTexture();
-		for (int cur = 0; cur < m_objs.size(); ++cur) {
-			if (m_objs[cur].getDisplayMode() != Object::MODE8) { continue; }
-			m_objs[cur].env_fbo.bind();
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			std::vector<glm::mat4> envVPMatrices = m_objs[cur].getEnvVPMatrices();
-			for (unsigned int i = 0; i < 6; i++) {
-				GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X + i;
-				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, face, m_objs[cur].env_texture.id, 0);
-				m_objs[cur].env_fbo.check();
-				glDepthFunc(GL_LEQUAL);
-				skybox.bind();
-				skybox.drawEnvMapping(programs[SKYBOX], view_control, envVPMatrices[i]);
+		assignEnvProbes();
+
+		// every out-of-date face, with what it sees
+		struct FaceUpdate {
+			int object;
+			int face;
+			bool first_fill;
+			float score;
+			std::vector<int> objects;
+		};
+		std::vector<FaceUpdate> pending;
+		glm::mat4 proj = view_control.getProjMatrix();
+		glm::vec3 view_dir = -glm::vec3(glm::inverse(view_control.getViewMatrix())[2]);
+		for (size_t cur = 0; cur < m_objs.size(); ++cur) {
+			if (m_objs[cur].env_probe < 0) { continue; }
+			EnvProbe& env = m_probes[m_objs[cur].env_probe];
+			glm::mat4 envProj = m_objs[cur].getEnvProjMatrix();
+			std::vector<glm::mat4> envViewMatrices = m_objs[cur].getEnvViewMatrices();
+
+			// share of the screen the mirror covers, from its bounding sphere
+			glm::vec3 lo, hi;
+			m_objs[cur].getWorldBounds(lo, hi);
+			glm::vec3 center = (lo + hi) * .5f;
+			float radius = glm::length(hi - lo) * .5f;
+			float depth = glm::dot(center - m_frame.eye, view_dir);
+			float coverage = 1.f;
+			if (depth < -radius) { coverage = 0.f; }
+			else if (depth > radius) {
+				float projected = radius * proj[1][1] / depth;
+				coverage = std::min(projected * projected, 1.f);
+			}
+
+			for (int face = 0; face < 6; ++face) {
+				FaceUpdate update;
+				uint64_t hash = envFaceHash((int)cur, face, envProj * envViewMatrices[face], update.objects);
+				bool moving = hash != env.face_latest[face];
+				env.face_latest[face] = hash;
+				update.first_fill = !(env.drawn_faces & (1 << face));
+				if (!update.first_fill && hash == env.face_hash[face]) {
+					env.face_stale[face] = 0;
+					++m_env_faces_skipped;
+					continue;
+				}
+				++env.face_stale[face];
+				update.object = (int)cur;
+				update.face = face;
+				update.score = (float)env.face_stale[face] * (1.f + env_coverage_weight * coverage) * (moving ? env_moving_weight : 1.f);
+				pending.push_back(std::move(update));
+			}
+		}
+
+		// first fills always, then the most urgent within the budget
+		std::stable_sort(pending.begin(), pending.end(), [](const FaceUpdate& a, const FaceUpdate& b) {
+			return a.first_fill != b.first_fill ? a.first_fill : a.score > b.score;
+		});
+		size_t n_drawn = 0;
+		while (n_drawn < pending.size() && (pending[n_drawn].first_fill || m_env_face_budget <= 0 || n_drawn < (size_t)m_env_face_budget)) {
+			++n_drawn;
+		}
+		for (auto&& update : pending) {
+			m_env_max_stale = std::max(m_env_max_stale, m_probes[m_objs[update.object].env_probe].face_stale[update.face]);
+		}
+		m_env_faces_drawn += n_drawn;
+		m_env_faces_deferred += pending.size() - n_drawn;
+		pending.resize(n_drawn);
+		if (pending.empty()) { return; }
+		// one framebuffer bind per probe
+		std::stable_sort(pending.begin(), pending.end(), [](const FaceUpdate& a, const FaceUpdate& b) {
+			return a.object < b.object;
+		});
+
+		LodView lod_view;
+		CullView cull_view;
+		cull_view.cones = true;
+		MeshletDraw draw;
+		std::vector<char> object_faces(m_objs.size(), 0);
+		std::vector<int> objects;
+		bool retargeted = false;
+		for (size_t first = 0, last; first < pending.size(); first = last) {
+			int cur = pending[first].object;
+			for (last = first; last < pending.size() && pending[last].object == cur; ++last) {}
+			EnvProbe& env = m_probes[m_objs[cur].env_probe];
+			env.fbo.bind();
+			glm::mat4 envProj = m_objs[cur].getEnvProjMatrix();
+			std::vector<glm::mat4> envViewMatrices = m_objs[cur].getEnvViewMatrices();
+			glm::vec3 probe = glm::vec3(m_objs[cur].getModelMatrix()[3]);
+			lod_view = lodView(ENV_LOD, probe, envProj[1][1], (float)m_probes.size());
+			cull_view.eye = probe;
+
+			if (m_layered_env) {
+				// both cubes attached once; every object is drawn once into all the faces it shows up in
+				if (!env.layered) {
+					glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, env.color.id, 0);
+					glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, env.depth.id, 0);
+					env.fbo.check();
+					env.layered = true;
+				}
+				int probe_faces = 0;
+				objects.clear();
+				for (size_t k = first; k < last; ++k) {
+					probe_faces |= 1 << pending[k].face;
+					for (int other : pending[k].objects) {
+						if (!object_faces[other]) { objects.push_back(other); }
+						object_faces[other] |= (char)(1 << pending[k].face);
+					}
+				}
+				glm::mat4 face_matrices[6], sky_matrices[6];
+				for (int i = 0; i < 6; ++i) {
+					face_matrices[i] = envProj * envViewMatrices[i];
+					sky_matrices[i] = envProj * glm::mat4(glm::mat3(envViewMatrices[i]));
+				}
+				const ShaderMode cube_programs[3] = { WIREFRAME_CUBE, FLAT_CUBE, PHONG_CUBE };
+				for (ShaderMode mode : cube_programs) {
+					programs[mode].bind();
+					glUniformMatrix4fv(programs[mode].uniform("faceMatrices"), 6, GL_FALSE, &face_matrices[0][0][0]);
+				}
+				Program& sky = programs[SKYBOX_CUBE];
+				sky.bind();
+				glUniformMatrix4fv(sky.uniform("faceMatrices"), 6, GL_FALSE, &sky_matrices[0][0][0]);
+				glUniform1i(sky.uniform("faceMask"), probe_faces);
+				// the skybox covers every pixel at the far plane, so drawn without a depth
+				// test it clears the faces being redrawn and leaves the others alone
+				glDepthFunc(GL_ALWAYS);
+				skybox.draw(sky, cubeInstances(probe_faces));
 				glDepthFunc(GL_LESS);
-				this->bind();
-				for (int other = 0; other < m_objs.size(); ++other) {
-					if (other == cur) { continue; }
-					m_objs[other].drawEnvMapping(programs, m_light, view_control, m_depth_texture, skybox_texture, envVPMatrices[i]);
+				for (int other : objects) {
+					Object& obj = m_objs[other];
+					int faces = object_faces[other];
+					object_faces[other] = 0;
+					cull_view.volumes.clear();
+					for (int i = 0; i < 6; ++i) {
+						if (faces & (1 << i)) { cull_view.volumes.push_back(face_matrices[i]); }
+					}
+					int lod = selectLod(obj, lod_view);
+					bool filled = obj.getDisplayMode() != Object::MODE1 && obj.getDisplayMode() != Object::MODE2;
+					bool culled = cullMeshlets(obj, lod, cull_view, filled, draw);
+					if (culled && draw.counts.empty()) { continue; }
+					drawObject(programs, obj, skybox_texture, lod, culled ? &draw : nullptr, faces);
 				}
 			}
-			m_objs[cur].env_fbo.unbind();
+			else {
+				// a pass per face
+				env.layered = false;
+				retargeted = true;
+				cull_view.volumes.resize(1);
+				for (size_t k = first; k < last; ++k) {
+					int i = pending[k].face;
+					GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X + i;
+					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, face, env.color.id, 0);
+					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, face, env.depth.id, 0);
+					env.fbo.check();
+					glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+					// one Frame upload per face; the faces are square, so no aspect correction
+					uploadFrame(envViewMatrices[i], envProj, glm::mat4(1.f));
+					cull_view.volumes[0] = envProj * envViewMatrices[i];
+					glDepthFunc(GL_LEQUAL);
+					skybox.draw(programs[SKYBOX]);
+					glDepthFunc(GL_LESS);
+					for (int other : pending[k].objects) {
+						Object& obj = m_objs[other];
+						int lod = selectLod(obj, lod_view);
+						bool filled = obj.getDisplayMode() != Object::MODE1 && obj.getDisplayMode() != Object::MODE2;
+						bool culled = cullMeshlets(obj, lod, cull_view, filled, draw);
+						if (culled && draw.counts.empty()) { continue; }
+						drawObject(programs, obj, skybox_texture, lod, culled ? &draw : nullptr);
+					}
+				}
+			}
+
+			for (size_t k = first; k < last; ++k) {
+				int i = pending[k].face;
+				env.face_hash[i] = env.face_latest[i];
+				env.face_stale[i] = 0;
+				env.drawn_faces |= 1 << i;
+			}
+		}
+		StateCache::bindFramebuffer(0);
+		// the layered programs leave the Frame block alone
+		if (retargeted) {
+			uploadFrame(view_control.getViewMatrix(), view_control.getProjMatrix(), view_control.getAspectRatioMatrix());
 		}
 	}
 
+	void Geometry::drawPlaceholders(Program& program) {
+		if (m_importer.inFlight() == 0) { return; }
+		ObjectBlock block = ObjectBlock();
+		block.model = glm::mat4(1.f);
+		block.color = glm::vec3(1.f, 1.f, 0.f);
+		m_object_ubo.update(&block, sizeof(ObjectBlock), 1, 1);
+		program.bind();
+		m_box_vao.bind();
+		glDrawElements(GL_LINES, m_box_ebo.cols, m_box_ebo.type, BUFFER_OFFSET(0));
+	}
+
 	void Geometry::draw(std::vector<Program>& programs, ViewControl& view_control, Skybox& skybox) {
+		pollImports();
+		refitBounds();
+		m_pick.poll();
+		updateFrame(view_control);
 		Texture skybox_texture = skybox.getTexture();
-		glViewport(0, 0, 1024, 1024);
-		getShadowTexture(programs[SHADOW], view_control);
-		glViewport(0, 0, Object::s_env_height, Object::s_env_width);
+		glViewport(0, 0, shadow_size, shadow_size);
+		getShadowTexture(programs);
+		glViewport(0, 0, m_probes.size(), m_probes.size());
 		getEnvTexture(programs, view_control, skybox);
 		glViewport(0, 0, view_control.screenWidth(), view_control.screenHeight());
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		for (auto&& obj : m_objs) {
-			if (obj.getDisplayMode() == Object::MODE8) {
-				obj.draw(programs, m_light, view_control, m_depth_texture, obj.env_texture);
+
+		// objects outside the camera frustum are skipped in the main pass only
+		std::vector<char> visible(m_objs.size(), 0);
+		m_tree.queryFrustum(m_frame.aspect_ratio * m_frame.view_proj,
+			[&visible](int index) { visible[index] = 1; });
+		// with screen-space mirrors in view the pass goes off screen first, to be traced
+		bool screen_mirrors = false;
+		for (size_t i = 0; i < m_objs.size() && m_ssr && !screen_mirrors; ++i) {
+			screen_mirrors = visible[i] && m_objs[i].getDisplayMode() == Object::MODE9;
+		}
+		if (screen_mirrors) {
+			m_reflection.begin((int)view_control.screenWidth(), (int)view_control.screenHeight());
+		}
+
+		// CPU side of the main pass: state changes and draw calls, not GPU time
+		auto t_start = std::chrono::high_resolution_clock::now();
+		glm::mat4 proj = view_control.getProjMatrix();
+		LodView lod_view = lodView(MAIN_LOD, m_frame.eye, proj[1][1], (float)view_control.screenHeight(), proj[3][3] == 1.f);
+		CullView cull_view;
+		cull_view.volumes.assign(1, m_frame.aspect_ratio * m_frame.view_proj);
+		cull_view.eye = m_frame.eye;
+		cull_view.cones = !lod_view.orthographic;
+		size_t n_submitted = 0;
+		// MODE8 objects each sample their own env map, so they stay on the per-object path
+		MeshletDraw draw;
+		for (size_t i = 0; i < m_objs.size(); ++i) {
+			if (visible[i] && m_objs[i].getDisplayMode() == Object::MODE8) {
+				int lod = selectLod(m_objs[i], lod_view);
+				bool culled = cullMeshlets(m_objs[i], lod, cull_view, true, draw);
+				if (culled && draw.counts.empty()) { continue; }
+				// without a probe (pool exhausted) it reflects the static skybox
+				Texture& env_texture = m_objs[i].env_probe >= 0 ? m_probes[m_objs[i].env_probe].color : skybox_texture;
+				drawObject(programs, m_objs[i], env_texture, lod, culled ? &draw : nullptr);
+				++n_submitted;
 			}
-			else {
-				obj.draw(programs, m_light, view_control, m_depth_texture, skybox_texture);
+		}
+		std::vector<InstanceData> instances;
+		std::vector<InstanceGroup> groups;
+		std::vector<MeshletDraw> draws;
+		buildInstances(false, &visible, &lod_view, &cull_view, instances, groups, draws);
+		if (!instances.empty()) {
+			m_instance_vbo.update(instances);
+		}
+		for (auto&& group : groups) {
+			Object::drawInstanced(programs, m_depth_texture, skybox_texture,
+				*group.mesh, group.lod, group.mode, m_instance_vbo, group.first, group.count,
+				group.draw >= 0 ? &draws[group.draw] : nullptr);
+		}
+		n_submitted += instances.size();
+		// MODE9 last, so nothing drawn over a mirror leaves its normal behind
+		if (screen_mirrors) {
+			m_reflection.mirrors();
+		}
+		for (size_t i = 0; i < m_objs.size(); ++i) {
+			if (visible[i] && m_objs[i].getDisplayMode() == Object::MODE9) {
+				int lod = selectLod(m_objs[i], lod_view);
+				bool culled = cullMeshlets(m_objs[i], lod, cull_view, true, draw);
+				if (culled && draw.counts.empty()) { continue; }
+				drawObject(programs, m_objs[i], skybox_texture, lod, culled ? &draw : nullptr);
+				++n_submitted;
+			}
+		}
+		auto t_end = std::chrono::high_resolution_clock::now();
+		m_submit_us += std::chrono::duration<double, std::micro>(t_end - t_start).count();
+		m_submitted += n_submitted;
+		if (screen_mirrors) {
+			m_reflection.resolve(programs[SSR], skybox_texture, m_frame.aspect_ratio * m_frame.view_proj, ssr_distance);
+		}
+		drawPlaceholders(programs[WIREFRAME]);
+		if (m_pick.wanted()) {
+			getPickTexture(programs[PICK], view_control);
+		}
+	}
+
+	void Geometry::getPickTexture(Program& program, ViewControl& view_control) {
+		m_pick.begin((int)view_control.screenWidth(), (int)view_control.screenHeight());
+		program.bind();
+		StateCache::polygonMode(GL_FILL);
+
+		// grouped by mesh only, like the shadow pass; triangle IDs refer to the full mesh
+		std::vector<InstanceData> instances;
+		std::vector<InstanceGroup> groups;
+		std::vector<MeshletDraw> draws;
+		buildInstances(true, nullptr, nullptr, nullptr, instances, groups, draws);
+		if (!instances.empty()) {
+			m_instance_vbo.update(instances);
+		}
+		for (auto&& group : groups) {
+			group.mesh->vao.bind();
+			size_t base = group.first * sizeof(InstanceData);
+			program.bindInstanceAttribArray("InstanceModel", m_instance_vbo, 4, 4, sizeof(InstanceData), base + offsetof(InstanceData, model));
+			program.bindInstanceAttribArray("InstanceObject", m_instance_vbo, 1, 1, sizeof(InstanceData), base + offsetof(InstanceData, object));
+			glDrawElementsInstanced(GL_TRIANGLES, group.mesh->lodCount(0), group.mesh->ebo.type, group.mesh->lodOffset(0), (GLsizei)group.count);
+		}
+		m_pick.end();
+	}
+
+	void Geometry::toggleGpuPicking() {
+		m_gpu_picking = !m_gpu_picking;
+		if (!m_gpu_picking) {
+			m_pick.cancel();
+		}
+		printf("\n[SYSTEM INFO::PICKING] GPU ID BUFFER || [STATUS] %s\n", m_gpu_picking ? "ACTIVE" : "DEACTIVE");
+	}
+
+	void Geometry::requestPick(ViewControl& view_control, double screen_x, double screen_y, const PickBuffer::Callback& callback) {
+		int x = (int)((screen_x + 1.0) * .5 * view_control.screenWidth());
+		int y = (int)((screen_y + 1.0) * .5 * view_control.screenHeight());
+		m_pick.request(x, y, callback);
+	}
+
+	void Geometry::cancelPick() {
+		m_pick.cancel();
+	}
+
+	void Geometry::buildInstances(bool shadow_pass, const std::vector<char>* visible, const LodView* lod_view,
+		const CullView* cull_view, std::vector<InstanceData>& instances, std::vector<InstanceGroup>& groups,
+		std::vector<MeshletDraw>& draws) {
+		// the shadow pass does not care about display modes
+		std::vector<int> order;
+		std::vector<int> lods(m_objs.size(), 0);
+		std::vector<int> draw_of(m_objs.size(), -1);
+		draws.clear();
+		MeshletDraw draw;
+		for (size_t i = 0; i < m_objs.size(); ++i) {
+			if (visible && !(*visible)[i]) { continue; }
+			Object::DisplayMode mode = m_objs[i].getDisplayMode();
+			if (!shadow_pass && (mode == Object::MODE8 || mode == Object::MODE9)) { continue; }
+			if (lod_view) { lods[i] = selectLod(m_objs[i], *lod_view); }
+			bool filled = shadow_pass || (mode != Object::MODE1 && mode != Object::MODE2);
+			if (cull_view && cullMeshlets(m_objs[i], lods[i], *cull_view, filled, draw)) {
+				if (draw.counts.empty()) { continue; }
+				draw_of[i] = (int)draws.size();
+				draws.push_back(draw);
+			}
+			order.push_back((int)i);
+		}
+		auto key = [&](int i) {
+			Object::DisplayMode mode = shadow_pass ? Object::MODE1 : m_objs[i].getDisplayMode();
+			return std::make_tuple(m_objs[i].getMesh().get(), lods[i], (int)mode);
+		};
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return key(a) < key(b); });
+
+		instances.clear();
+		groups.clear();
+		for (int i : order) {
+			const Object& obj = m_objs[i];
+			Object::DisplayMode mode = shadow_pass ? Object::MODE1 : obj.getDisplayMode();
+			// culled meshlets differ per object, so those objects are drawn on their own
+			if (groups.empty() || groups.back().mesh != obj.getMesh().get() || groups.back().lod != lods[i] || groups.back().mode != mode
+				|| groups.back().draw >= 0 || draw_of[i] >= 0) {
+				InstanceGroup group = { obj.getMesh().get(), lods[i], mode, draw_of[i], instances.size(), 0 };
+				groups.push_back(group);
 			}
+			instances.push_back(obj.getInstanceData());
+			instances.back().object = (float)i;
+			++groups.back().count;
 		}
 	}
 
 	void Geometry::addObjFromOffFile(const std::string& path) {
-		Object obj;
-		obj.loadFromOffFile(path);
-		obj.unitize();
-		obj.update();
-		m_objs.push_back(obj);
+		m_importer.submit(path);
+	}
+
+	void Geometry::pollImports() {
+		MeshData::ptr mesh;
+		while (m_importer.poll(mesh)) {
+			if (!mesh->error.empty()) {
+				printf("[SYSTEM INFO::MESH LOADER] %s || [ERROR] %s\n", mesh->path.c_str(), mesh->error.c_str());
+				continue;
+			}
+			// also catches a second request that was parsed before the first one landed
+			MeshAsset::ptr asset = m_registry.find(mesh->path, mesh->source_hash);
+			if (!asset && mesh->shared) {
+				// the last user went away while the request was in flight
+				m_importer.submit(mesh->path, false);
+				continue;
+			}
+			if (!asset) {
+				asset = std::make_shared<MeshAsset>();
+				asset->loadFromMeshData(*mesh);
+				m_registry.add(asset);
+			}
+			m_objs.push_back(Object());
+			m_objs.back().setMesh(asset);
+			track((int)m_objs.size() - 1);
+			printf("[SYSTEM INFO::MESH LOADER] %s || ADDED TO SCENE (%d USERS)\n", mesh->path.c_str(), (int)asset.use_count() - 1);
+		}
 	}
 
 	void Geometry::addBunny() {
@@ -535,28 +1263,73 @@ namespace SceneEditor {
 		obj.update();
 		obj.setDisplayMode(Object::DisplayMode::MODE2);
 		m_objs.push_back(obj);
+		track((int)m_objs.size() - 1);
 	}
 
 	void Geometry::deleteObject(int index) {
 		ASSERT(index < m_objs.size(), "deleteObject(index): index out of range");
+		// the mesh buffers go with the last object that uses them
+		m_tree.remove(m_objs[index].proxy);
+		m_probes.release(m_objs[index].env_probe);
+		m_objs[index].free();
 		m_objs.erase(m_objs.begin() + index);
+		for (int i = index; i < m_objs.size(); ++i) {
+			m_tree.setUser(m_objs[i].proxy, i);
+		}
+		// its shadow may be in the cached cube
+		m_shadow_dirty = true;
 	}
 
-	int Geometry::intersectRay(const glm::vec3& e, const glm::vec3& d, float vnear, float vfar) const {
-		float min_t = std::numeric_limits<float>::max();
+	int Geometry::intersectRay(const glm::vec3& e, const glm::vec3& d, float vnear, float vfar) {
+		refitBounds();
 		int res = -1;
-		for (int i = 0; i < m_objs.size(); ++i) {
-			auto p = m_objs[i].intersectRay(e, d, vnear, vfar);
-			if (p.first) {
-				if (p.second < min_t) {
-					min_t = p.second;
-					res = i;
-				}
+		// only objects whose box the ray enters get per-triangle tests
+		m_tree.raycast(e, d, vnear, vfar, [&](int index, float far) {
+			auto p = m_objs[index].intersectRay(e, d, vnear, far);
+			if (p.first && p.second <= far) {
+				res = index;
+				return p.second;
 			}
-		}
+			return far;
+		});
 		return res;
 	}
 
+	void Geometry::track(int index) {
+		glm::vec3 lo, hi;
+		m_objs[index].getWorldBounds(lo, hi);
+		m_objs[index].proxy = m_tree.insert(lo, hi, index);
+		m_objs[index].clearBoundsDirty();
+	}
+
+	void Geometry::refitBounds() {
+		for (auto&& obj : m_objs) {
+			if (!obj.boundsDirty() || obj.proxy < 0) { continue; }
+			glm::vec3 lo, hi;
+			obj.getWorldBounds(lo, hi);
+			m_tree.move(obj.proxy, lo, hi);
+			obj.clearBoundsDirty();
+		}
+	}
+
+	double Geometry::submitTimePerObject() const {
+		return m_submitted ? m_submit_us / (double)m_submitted : 0.0;
+	}
+
+	void Geometry::resetCounters() {
+		m_submit_us = 0.0;
+		m_submitted = 0;
+		m_meshlets_tested = 0;
+		m_meshlets_drawn = 0;
+		m_shadow_triangles = 0;
+		m_shadow_updates = 0;
+		m_shadow_bakes = 0;
+		m_env_faces_drawn = 0;
+		m_env_faces_deferred = 0;
+		m_env_faces_skipped = 0;
+		m_env_max_stale = 0;
+	}
+
 	size_t Geometry::size() const { return m_objs.size(); }
 
 	const Object& Geometry::operator[](size_t index) const {
@@ -5,6 +5,12 @@
 #include "../../view/ViewControl.h"
 #include "../features/LightClass.h"
 #include "../features/Skybox.h"
+#include "../features/ImporterClass.h"
+#include "../features/AabbTreeClass.h"
+#include "../features/PickBufferClass.h"
+#include "../features/ReflectionBufferClass.h"
+#include "MeshAssetClass.h"
+#include "EnvProbeClass.h"
 
 #include <glm/glm.hpp> // glm::vec3
 #include <glm/vec3.hpp>
@@ -19,7 +25,54 @@ namespace SceneEditor {
 		PHONG = 2,
 		SHADOW = 3,
 		SKYBOX = 4,
-		N_SHADER = 5
+		WIREFRAME_INSTANCED = 5,
+		FLAT_INSTANCED = 6,
+		PHONG_INSTANCED = 7,
+		SHADOW_INSTANCED = 8,
+		PICK = 9,
+		SHADOW_LAYERED = 10,  // instanced, one cube face per draw through gl_Layer
+		WIREFRAME_CUBE = 11,  // the env map variants: one instance per cube face through gl_Layer
+		FLAT_CUBE = 12,
+		PHONG_CUBE = 13,
+		SKYBOX_CUBE = 14,
+		SSR = 15,             // full-screen resolve of the MODE9 mirrors
+		N_SHADER = 16
+	};
+
+	// Per-instance attributes of the instanced shaders
+	struct InstanceData {
+		glm::mat4 model;
+		glm::mat3 normal;
+		glm::vec3 color;
+		float object;  // index in the scene, read by the pick shader
+	};
+
+	// std140 mirror of the "Frame" uniform block: everything shared by the
+	// draws of one pass, uploaded once per pass instead of once per object
+	struct FrameBlock {
+		glm::mat4 view;
+		glm::mat4 proj;
+		glm::mat4 view_proj;
+		glm::mat4 aspect_ratio;
+		glm::mat4 shadow[6];   // light space of each cube face
+		glm::vec3 eye;
+		float far_plane;
+		glm::vec3 light;
+		int red_shadow;
+	};
+
+	// std140 mirror of the "Object" uniform block, for the per-object path
+	struct ObjectBlock {
+		glm::mat4 model;
+		glm::vec4 normal[3];   // mat3 columns are padded to vec4
+		glm::vec3 color;
+		float pad;
+	};
+
+	// Meshlets of one object that survived a view, as glMultiDrawElements arguments
+	struct MeshletDraw {
+		std::vector<GLsizei> counts;
+		std::vector<const void*> offsets;
 	};
 
 	class Object {
@@ -33,71 +86,112 @@ namespace SceneEditor {
 			MODE6 = 5,  // FLAT + MIRROR
 			MODE7 = 6,  // FLAT + REFRACTION
 			MODE8 = 7,  // PHONG + MIRROR(DYNAMIC)
+			MODE9 = 8,  // PHONG + MIRROR(SCREEN SPACE)
 		};
 		Object();
 		void free();
-		void draw(std::vector<Program>& programs, Light& light, ViewControl& view_control, Texture& depth_texture, Texture& skybox_texture, bool isEnvMap = false);
-		void drawEnvMapping(std::vector<Program>& programs, Light& light, ViewControl& view_control, Texture& depth_texture, Texture& skybox_texture, glm::mat4& VPMatrix);
+		// The per-object draws read the Object block, which has to hold getObjectBlock().
+		// With meshlets only those ranges of the level are drawn. A cube_faces mask draws
+		// with the *_CUBE programs into those faces of a layered cube target.
+		void draw(std::vector<Program>& programs, Texture& depth_texture, Texture& skybox_texture, int lod = 0,
+			const MeshletDraw* meshlets = nullptr, int cube_faces = 0);
 		void drawShadowMapping(Program& program);
+		// Draws count instances of level lod of mesh, reading InstanceData from instances starting at first.
+		// A meshlet draw is for a single instance (count 1).
+		static void drawInstanced(std::vector<Program>& programs, Texture& depth_texture, Texture& skybox_texture,
+			MeshAsset& mesh, int lod, DisplayMode mode, VertexBufferObject& instances, size_t first, size_t count,
+			const MeshletDraw* meshlets = nullptr);
+		static void drawShadowMappingInstanced(Program& program, MeshAsset& mesh, int lod, VertexBufferObject& instances, size_t first, size_t count,
+			const MeshletDraw* meshlets = nullptr);
+		InstanceData getInstanceData() const;
+		ObjectBlock getObjectBlock() const;
 		void loadFromOffFile(const std::string& path);
+		void setMesh(const MeshAsset::ptr& mesh);
+		const MeshAsset::ptr& getMesh() const { return m_mesh; }
 		void unitize();
 		void update();
-		void configEnvMap();
 		void setDisplayMode(DisplayMode mode);
-		DisplayMode getDisplayMode();
+		DisplayMode getDisplayMode() const;
 
 		void translate(float x, float y, float z);
 		void rotate(float x, float y, float z);
 		void scale(float change);
 		void color(glm::vec3& color);
+		const glm::vec3& getColor() const { return m_color; }
 		void inverseColor();
 
 		std::pair<bool, float> intersectRay(const glm::vec3& e, const glm::vec3& d, float near, float far) const;
+		// Ray e + t * d against triangle abc (Cramer's rule), t in [near, far]
+		static std::pair<bool, float> intersectTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
+			const glm::vec3& e, const glm::vec3& d, float near, float far);
+		// World-space box around the transformed mesh bounds
+		void getWorldBounds(glm::vec3& lo, glm::vec3& hi) const;
+		// Set whenever the transform changes; cleared by whoever refits the scene tree
+		bool boundsDirty() const { return m_bounds_dirty; }
+		void clearBoundsDirty() { m_bounds_dirty = false; }
+		int proxy;  // leaf in the scene tree, -1 if not tracked
+		// Bumped whenever the transform or the mesh changes
+		unsigned version() const { return m_version; }
+		unsigned shadow_version;  // version() when the shadow pass last looked
+		int still_frames;         // shadow passes since it last changed
 
 		glm::mat4 getModelMatrix() const;
 		glm::mat3 getNormalMatrix() const;
-		std::vector<glm::mat4> getEnvVPMatrices() const;
+		glm::mat4 getEnvProjMatrix() const;
+		std::vector<glm::mat4> getEnvViewMatrices() const;
 	private:
-		static std::pair<bool, float> intersectTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
-			const glm::vec3& e, const glm::vec3& d, float near, float far);
-		void drawWireframe(Program& program, Light& light, ViewControl& view_control, bool isEnvMap);
-		void setPhongShading(Program& program, ViewControl& view_control, bool isEnvMap);
-		void setFlatShading(Program& program, ViewControl& view_control, bool isEnvMap);
-		void setPhongLighting(Program& program, Light& light, ViewControl& view_control, Texture& depth_texture);
-		void setMirrorLighting(Program& program, Light& light, ViewControl& view_control, Texture& depth_texture, Texture& skybox_texture);
-		void setRefractLighting(Program& program, Light& light, ViewControl& view_control, Texture& depth_texture, Texture& skybox_texture);
-		void simpleDraw();
+		void drawWireframe(Program& program, int lod, const MeshletDraw* meshlets, int cube_faces);
+		void setPhongShading(Program& program);
+		void setFlatShading(Program& program);
+		static void setPhongLighting(Program& program, Texture& depth_texture);
+		static void setMirrorLighting(Program& program, Texture& depth_texture, Texture& skybox_texture);
+		// The static mirror, which also leaves its normal for the screen-space resolve
+		static void setScreenMirrorLighting(Program& program, Texture& depth_texture, Texture& skybox_texture);
+		static void setRefractLighting(Program& program, Texture& depth_texture, Texture& skybox_texture);
+		static void setInstancedShading(Program& program, MeshAsset& mesh, VertexBufferObject& instances, size_t first);
+		static void instancedDraw(MeshAsset& mesh, int lod, size_t count, const MeshletDraw* meshlets);
+		static void setCubeFaces(Program& program, int cube_faces);
+		void simpleDraw(int lod = 0, const MeshletDraw* meshlets = nullptr, GLsizei instances = 1);
+		void updateModelMatrix();
 	private:
-		std::vector<glm::vec3> m_vertices;
-		std::vector<glm::vec3> m_vertex_normals;
-		std::vector<int> m_indices;
+		MeshAsset::ptr m_mesh;
 		std::vector<float> m_model;  // 0,1,2 - translate, 3,4,5 - rotate, 6 - sacle
+		glm::mat4 m_model_matrix;          // kept in sync with m_model
+		glm::mat4 m_inverse_model_matrix;  // world -> object space, for picking
+		bool m_bounds_dirty;
+		unsigned m_version;
 		glm::vec3 m_color;  // 0,1,2 - rgb
 		DisplayMode m_mode;
 
-		VertexBufferObject m_vbo;
-		ElementBufferObject m_ebo;
-		VertexBufferObject m_nbo;   // vbo for vertex normal
-
 	public:
-		FrameBufferObject env_fbo;
-		Texture env_texture;
-		static const int s_env_width = 2000;
-		static const int s_env_height = 2000;
-	private:
-		glm::mat4 m_envVPMatrix;
+		int env_probe;  // slot in the Geometry's probe pool while in MODE8, -1 otherwise
 	};
 
 	class Geometry {
 	public:
+		// When the shadow cube is rebuilt
+		enum ShadowCaching {
+			SHADOW_EVERY_FRAME = 0,
+			SHADOW_ON_CHANGE = 1,    // after the light or a caster changed, else the cube is kept
+			SHADOW_STATIC_SPLIT = 2  // settled casters are baked into a cached cube, moving ones drawn over a copy
+		};
+
+		// Passes that pick their own level of detail
+		enum LodPass {
+			MAIN_LOD = 0,    // camera
+			SHADOW_LOD = 1,  // the six light faces
+			ENV_LOD = 2,     // the six faces of each MODE8 env map
+			N_LOD_PASS = 3
+		};
+
 		Geometry();
 		void init();
 		void free();
-		void bind();
 		void configShadowMap();
 		size_t size() const;
 		void draw(std::vector<Program>& programs, ViewControl& view_control, Skybox& skybox);
 		void addObjFromOffFile(const std::string& path);
+		void pollImports();
 
 		void addBunny();
 		void addBumpyCube();
@@ -105,21 +199,160 @@ namespace SceneEditor {
 		void addPlane();
 		void deleteObject(int index);
 
-		int intersectRay(const glm::vec3& e, const glm::vec3& d, float near, float far) const;
+		int intersectRay(const glm::vec3& e, const glm::vec3& d, float near, float far);
+		// Brings the scene tree up to date with moved objects
+		void refitBounds();
+		const AabbTree& tree() const { return m_tree; }
+
+		// GPU picking: the pixel under (screen_x, screen_y) is read from an ID
+		// buffer and handed to callback a frame or more later
+		bool gpuPicking() const { return m_gpu_picking; }
+		void toggleGpuPicking();
+		void requestPick(ViewControl& view_control, double screen_x, double screen_y, const PickBuffer::Callback& callback);
+		void cancelPick();
 
 		const Object& operator[](size_t index) const;
 		Object& operator[](size_t index);
 		Light& getLight() { return m_light; }
 		void redShadow();
+
+		// log2 of the screen error, in pixels, a pass accepts from a coarser level
+		void setLodBias(LodPass pass, float bias);
+		// Needs programs[SHADOW_LAYERED]; without it the geometry shader fills all six faces
+		void setVertexLayerShadows(bool enabled) { m_vertex_layer = enabled; }
+		// Needs the *_CUBE programs; without them every env map face is a pass of its own
+		void setLayeredEnvMaps(bool enabled) { m_layered_env = enabled; }
+		// Needs programs[SSR]; without it MODE9 objects reflect the static skybox like MODE4
+		void setScreenSpaceReflections(bool enabled) { m_ssr = enabled; }
+		void setShadowCaching(ShadowCaching caching);
+		// Face size, format and count of the MODE8 env maps; drops the current ones
+		void configEnvProbes(int size, EnvProbePool::Format format, size_t capacity);
+		// Env map faces redrawn per frame at most, 0 for no limit; a probe's first fill ignores it
+		void setEnvFaceBudget(int faces) { m_env_face_budget = faces; }
+		int envFaceBudget() const { return m_env_face_budget; }
+
+		// CPU time spent submitting the main pass, per drawn object, since the last reset
+		double submitTimePerObject() const;
+		// Meshlets tested and kept by every pass since the last reset
+		size_t meshletsTested() const { return m_meshlets_tested; }
+		size_t meshletsDrawn() const { return m_meshlets_drawn; }
+		// Triangles rasterized into the shadow cube, counting every face
+		size_t shadowTriangles() const { return m_shadow_triangles; }
+		// Frames that drew into the shadow cube, and bakes of the static cube
+		size_t shadowUpdates() const { return m_shadow_updates; }
+		size_t shadowBakes() const { return m_shadow_bakes; }
+		// Env map faces drawn, left out of date by the budget and found unchanged, since the last reset
+		size_t envFacesDrawn() const { return m_env_faces_drawn; }
+		size_t envFacesDeferred() const { return m_env_faces_deferred; }
+		size_t envFacesSkipped() const { return m_env_faces_skipped; }
+		// Frames the stalest face drawn or deferred had been out of date
+		int envMaxStaleness() const { return m_env_max_stale; }
+		void resetCounters();
 	private:
-		void getShadowTexture(Program& program, ViewControl& view_control);
+		// Fills the Frame block for the camera and uploads it
+		void updateFrame(ViewControl& view_control);
+		// Re-targets the Frame block to another view (env map faces) and uploads it
+		void uploadFrame(const glm::mat4& view, const glm::mat4& proj, const glm::mat4& aspect_ratio);
+		void drawObject(std::vector<Program>& programs, Object& obj, Texture& skybox_texture, int lod = 0,
+			const MeshletDraw* meshlets = nullptr, int cube_faces = 0);
+		// Brings the shadow cube up to date as m_shadow_caching allows
+		void getShadowTexture(std::vector<Program>& programs);
+		// Draws casters (one flag per object, null for all) into the bound cube. SHADOW_LAYERED
+		// draws each face on its own, SHADOW_INSTANCED all six at once.
+		void drawShadowCasters(std::vector<Program>& programs, const std::vector<char>* casters);
+		// Hands probes to objects that entered MODE8 and takes them back from those that left
+		void assignEnvProbes();
+		// Redraws the env map faces that are out of date, most urgent first, up to the face budget;
+		// layered, each probe is a single pass with every object drawn once into its faces
 		void getEnvTexture(std::vector<Program>& programs, ViewControl& view_control, Skybox& skybox);
+		// What face of obj's probe would show: the light, the shadow cube, the probe's own
+		// position and every object in the face's frustum; objects receives those objects
+		uint64_t envFaceHash(int obj, int face, const glm::mat4& view_proj, std::vector<int>& objects) const;
+		void getPickTexture(Program& program, ViewControl& view_control);
+		void drawPlaceholders(Program& program);
+		void track(int index);
+
+		// What a pass needs to turn a mesh error into pixels
+		struct LodView {
+			glm::vec3 eye;
+			float pixels_per_unit;  // at distance 1, or anywhere when orthographic
+			bool orthographic;
+			float bias;
+		};
+		// focal is proj[1][1]; height is the viewport's in pixels
+		LodView lodView(LodPass pass, const glm::vec3& eye, float focal, float height, bool orthographic = false) const;
+		// Coarsest level whose projected error stays within the pass's allowance
+		int selectLod(const Object& obj, const LodView& view) const;
+
+		// What a pass culls meshlets against
+		struct CullView {
+			std::vector<glm::mat4> volumes;  // world -> clip; a meshlet in any of them is kept
+			glm::vec3 eye;
+			bool cones;  // false for orthographic views
+		};
+		// Fills draw with the meshlets of level lod that view keeps; false when
+		// the level has no meshlets and is drawn whole
+		bool cullMeshlets(const Object& obj, int lod, const CullView& view, bool filled, MeshletDraw& draw);
+
+		// Objects sharing a mesh, level (and display mode) drawn with one instanced call
+		struct InstanceGroup {
+			MeshAsset* mesh;
+			int lod;
+			Object::DisplayMode mode;
+			int draw;  // index in the meshlet draws, or -1; such a group holds one object
+			size_t first;
+			size_t count;
+		};
+		// visible (one flag per object) may be null to keep every object; without
+		// lod_view every object draws its full mesh, without cull_view every meshlet
+		void buildInstances(bool shadow_pass, const std::vector<char>* visible, const LodView* lod_view,
+			const CullView* cull_view, std::vector<InstanceData>& instances, std::vector<InstanceGroup>& groups,
+			std::vector<MeshletDraw>& draws);
 	private:
 		std::vector<Object> m_objs;
-		VertexArrayObject m_vao;
+		Importer m_importer;
+		MeshRegistry m_registry;
+		AabbTree m_tree;  // world bounds of m_objs, user data is the object index
+		VertexBufferObject m_instance_vbo;
+		VertexBufferObject m_shadow_instance_vbo;
+		VertexBufferObject m_box_vbo;   // placeholder box for meshes still importing
+		ElementBufferObject m_box_ebo;
+		VertexArrayObject m_box_vao;
+		UniformBufferObject m_frame_ubo;
+		UniformBufferObject m_object_ubo;
+		FrameBlock m_frame;
 		Light m_light;
 		FrameBufferObject m_depth_fbo;
 		Texture m_depth_texture;
+		PickBuffer m_pick;
+		ReflectionBuffer m_reflection;
+		bool m_gpu_picking;
+		float m_lod_bias[N_LOD_PASS];
+		double m_submit_us;
+		size_t m_submitted;
+		size_t m_meshlets_tested;
+		size_t m_meshlets_drawn;
+		bool m_vertex_layer;
+		bool m_layered_env;
+		bool m_ssr;
+		size_t m_shadow_triangles;
+		ShadowCaching m_shadow_caching;
+		bool m_shadow_dirty;          // rebuild everything at the next shadow pass
+		glm::mat4 m_shadow_faces[6];  // light matrices the cube was built with
+		float m_shadow_far;
+		FrameBufferObject m_static_fbo;  // settled casters only, for SHADOW_STATIC_SPLIT
+		Texture m_static_texture;
+		FrameBufferObject m_copy_read_fbo;
+		FrameBufferObject m_copy_draw_fbo;
+		size_t m_shadow_updates;
+		size_t m_shadow_bakes;
+		uint32_t m_shadow_generation;  // bumped whenever the shadow cube changes; never reset
+		EnvProbePool m_probes;
+		int m_env_face_budget;
+		size_t m_env_faces_drawn;
+		size_t m_env_faces_deferred;
+		size_t m_env_faces_skipped;
+		int m_env_max_stale;
 	};
 }
 #endif  // __GEOMETRY_H__
@@ -0,0 +1,143 @@
+#include "MeshAssetClass.h"
+#include "../features/MacroClass.h"
+
+#include <glm/common.hpp> // glm::min, glm::max
+
+#include <limits>
+#include <cstdio>
+
+namespace SceneEditor {
+
+	VertexFormat MeshAsset::s_format;
+
+	MeshAsset::MeshAsset() : source_hash{ 0 }, bounds_min{ 0.f }, bounds_max{ 0.f }, closed{ false }, decode{ 1.f } {
+		vbo.init();
+		ebo.init();
+		vao.init();
+	}
+
+	MeshAsset::~MeshAsset() {
+		vbo.free();
+		ebo.free();
+		vao.free();
+	}
+
+	void MeshAsset::loadFromMeshData(MeshData& mesh) {
+		path = mesh.path;
+		source_hash = mesh.source_hash;
+		vertices.swap(mesh.vertices);
+		indices.swap(mesh.indices);
+		normals.swap(mesh.normals);
+		lods.swap(mesh.lods);
+		meshlets.swap(mesh.meshlets);
+		closed = mesh.closed;
+		bounds_min = mesh.bounds_min;
+		bounds_max = mesh.bounds_max;
+		std::swap(bvh, mesh.bvh);
+		if (mesh.cache) {
+			// the cache holds the streams in s_format already; upload straight from the mapping
+			const MeshCache& cache = *mesh.cache;
+			decode = cache.decode();
+			upload(cache.vertexStream(), cache.vertexCount(), cache.indexStream(), cache.indexBytes(),
+				cache.indexCount(), cache.indexCount() + cache.lodIndexCount());
+		}
+		else {
+			encode(vertices.data(), normals.data(), vertices.size(), indices.data(), indices.size(), mesh.lod_indices);
+		}
+	}
+
+	void MeshAsset::update() {
+		std::vector<int> lod_indices;
+		MeshSimplifier::buildChain(vertices, indices, MeshSimplifier::s_lod_ratios, lod_indices, lods);
+		Meshlets::build(vertices, indices, lod_indices, lods, meshlets);
+		closed = Meshlets::closed(indices);
+		encode(vertices.data(), normals.data(), vertices.size(), indices.data(), indices.size(), lod_indices);
+	}
+
+	const void* MeshAsset::indexOffset(size_t first) const {
+		size_t index_bytes = ebo.type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(int);
+		return BUFFER_OFFSET(first * index_bytes);
+	}
+
+	void MeshAsset::encode(const glm::vec3* positions, const glm::vec3* normals, size_t n_vertices,
+		const int* indices, size_t n_indices, const std::vector<int>& lod_indices) {
+		std::vector<unsigned char> interleaved;
+		s_format.encode(positions, normals, n_vertices, interleaved, decode);
+		size_t index_bytes = VertexFormat::indexBytes(n_vertices);
+		size_t n_total = n_indices + lod_indices.size();
+		if (index_bytes == sizeof(int) && lod_indices.empty()) {
+			upload(interleaved.data(), n_vertices, reinterpret_cast<const unsigned char*>(indices), index_bytes, n_indices, n_total);
+			return;
+		}
+		std::vector<unsigned char> all_indices;
+		VertexFormat::encodeIndices(indices, n_indices, lod_indices, n_vertices, all_indices);
+		upload(interleaved.data(), n_vertices, all_indices.data(), index_bytes, n_indices, n_total);
+	}
+
+	void MeshAsset::upload(const unsigned char* vertex_stream, size_t n_vertices,
+		const unsigned char* index_stream, size_t index_bytes, size_t n_indices, size_t n_total) {
+		GLsizei stride = s_format.stride();
+
+		// the element buffer upload binds into whichever VAO is current
+		vao.bind();
+		vbo.update(vertex_stream, stride, n_vertices, 0);
+		// the levels go after the full mesh in the same buffer
+		ebo.update(index_stream, index_bytes, n_total, 1);
+		if (lods.empty()) {
+			lods.assign(1, MeshLod());
+			lods[0].count = n_indices;
+		}
+		vao.attribute(POSITION_ATTRIB, vbo, s_format.positionAttrib(), stride);
+		vao.attribute(NORMAL_ATTRIB, vbo, s_format.normalAttrib(), stride);
+		ebo.bind();
+
+		// against separate float3 position and normal buffers with 32-bit indices
+		size_t before = n_vertices * 2 * sizeof(glm::vec3) + n_total * sizeof(int);
+		size_t after = n_vertices * stride + n_total * index_bytes;
+		printf("[SYSTEM INFO::MESH LOADER] %s || %s, %d-BIT INDICES: %zu -> %zu BYTES (%.1fx)\n",
+			path.c_str(), s_format.name().c_str(), (int)index_bytes * 8, before, after,
+			after ? (double)before / (double)after : 0.0);
+	}
+
+	void MeshAsset::computeBounds() {
+		glm::vec3 lo(std::numeric_limits<float>::max());
+		glm::vec3 hi(std::numeric_limits<float>::lowest());
+		for (auto&& v : vertices) {
+			lo = glm::min(lo, v);
+			hi = glm::max(hi, v);
+		}
+		bounds_min = lo;
+		bounds_max = hi;
+	}
+
+	MeshAsset::ptr MeshRegistry::find(const std::string& path, uint64_t source_hash) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_assets.find(Key(path, source_hash));
+		return it == m_assets.end() ? MeshAsset::ptr() : it->second.lock();
+	}
+
+	bool MeshRegistry::contains(const std::string& path, uint64_t source_hash) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_assets.find(Key(path, source_hash));
+		return it != m_assets.end() && !it->second.expired();
+	}
+
+	void MeshRegistry::add(const MeshAsset::ptr& asset) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		prune();
+		m_assets[Key(asset->path, asset->source_hash)] = asset;
+	}
+
+	size_t MeshRegistry::size() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		prune();
+		return m_assets.size();
+	}
+
+	void MeshRegistry::prune() {
+		for (auto it = m_assets.begin(); it != m_assets.end(); ) {
+			if (it->second.expired()) { it = m_assets.erase(it); }
+			else { ++it; }
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#ifndef __MESH_ASSET_H__
+#define __MESH_ASSET_H__
+
+#include "../../helper/HelperClass.h"
+#include "../features/ImporterClass.h"
+#include "../features/VertexFormatClass.h"
+#include "../features/MeshSimplifierClass.h"
+#include "../features/MeshletClass.h"
+
+#include <glm/vec3.hpp> // glm::vec3
+#include <glm/mat4x4.hpp> // glm::mat4
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SceneEditor {
+
+	/* [MESH ASSET]
+	* Geometry and GPU buffers of one mesh, shared by every Object that
+	* shows it. The buffers are released with the last reference.
+	*/
+	class MeshAsset {
+	public:
+		typedef std::shared_ptr<MeshAsset> ptr;
+
+		MeshAsset();
+		~MeshAsset();
+
+		// Takes over the CPU data of an imported mesh and uploads it
+		void loadFromMeshData(MeshData& mesh);
+		// Rebuilds the LOD chain and meshlets, uploads vertices, normals and indices in s_format and records them in vao
+		void update();
+		void computeBounds();
+		// Byte offset of a level in ebo, for the draw calls
+		const void* lodOffset(int lod) const { return indexOffset(lods[lod].first); }
+		// Byte offset of an index in ebo
+		const void* indexOffset(size_t first) const;
+		GLsizei lodCount(int lod) const { return (GLsizei)lods[lod].count; }
+
+		std::string path;
+		uint64_t source_hash;
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec3> normals;
+		std::vector<int> indices;
+		glm::vec3 bounds_min;
+		glm::vec3 bounds_max;
+		Bvh bvh;  // over vertices/indices, for ray picking
+		// lods[0] is indices, the rest follow it in ebo; picking only uses lods[0]
+		std::vector<MeshLod> lods;
+		// ranges of ebo with bounds, for per-view culling of the large levels
+		std::vector<Meshlet> meshlets;
+		bool closed;  // watertight: meshlets facing away can be culled
+
+		VertexBufferObject vbo;   // position and normal, interleaved in s_format
+		ElementBufferObject ebo;  // every level, 16-bit when every index fits
+		// position, vertex_normal and ebo at their fixed locations; a draw
+		// only binds this and adds the instance attributes, if any
+		VertexArrayObject vao;
+		// stored positions -> mesh space; goes in front of the model matrix on the GPU
+		glm::mat4 decode;
+
+		// Layout of every mesh uploaded from now on
+		static VertexFormat s_format;
+
+	private:
+		// Encodes in s_format for meshes without a valid cache, then uploads
+		void encode(const glm::vec3* positions, const glm::vec3* normals, size_t n_vertices,
+			const int* indices, size_t n_indices, const std::vector<int>& lod_indices);
+		// Vertices in s_format, then every level index_bytes wide; decode must already be set
+		void upload(const unsigned char* vertex_stream, size_t n_vertices,
+			const unsigned char* index_stream, size_t index_bytes, size_t n_indices, size_t n_total);
+
+		MeshAsset(const MeshAsset&);
+		MeshAsset& operator=(const MeshAsset&);
+	};
+
+	/* [MESH REGISTRY]
+	* Live assets keyed by source path and content hash. Only weak references
+	* are kept, so the registry never extends an asset's lifetime. contains()
+	* may be called from the importer threads.
+	*/
+	class MeshRegistry {
+	public:
+		MeshAsset::ptr find(const std::string& path, uint64_t source_hash);
+		bool contains(const std::string& path, uint64_t source_hash);
+		void add(const MeshAsset::ptr& asset);
+		// Number of assets that are still alive
+		size_t size();
+
+	private:
+		typedef std::pair<std::string, uint64_t> Key;
+		void prune();
+
+		std::map<Key, std::weak_ptr<MeshAsset>> m_assets;
+		std::mutex m_mutex;
+	};
+}
+
+#endif // __MESH_ASSET_H__
@@ -6,6 +6,7 @@
 #include "helper/CallbackClass.h"
 #include "view/ViewControl.h"
 #include "lib/features/Skybox.h"
+#include "lib/features/MeshClass.h"
 
 // GLFW Library
 #ifdef __APPLE__
@@ -37,6 +38,58 @@ static const int WINDOW_WIDTH = 800;
 static const int WINDOW_HEIGHT = 600;
 static const char WINDOW_TITLE[] = "[Assignment-4] Environment Mapping and Shadow Mapping";
 
+/* [VERTEX FORMAT]
+*  Positions: FLOAT_POSITIONS, HALF_POSITIONS, UNORM16_POSITIONS
+*  Normals: FLOAT_NORMALS, PACKED_NORMALS, OCTAHEDRAL_NORMALS
+*/
+static const VertexFormat VERTEX_FORMAT(VertexFormat::UNORM16_POSITIONS, VertexFormat::PACKED_NORMALS);
+
+/* [NORMAL WEIGHTING]
+*  UNIFORM_WEIGHTS, AREA_WEIGHTS, ANGLE_WEIGHTS
+*/
+static const Mesh::NormalWeighting NORMAL_WEIGHTING = Mesh::AREA_WEIGHTS;
+
+/* [LEVEL OF DETAIL]
+*  LOD_RATIOS: triangle count of each coarser level against the full mesh
+*  *_LOD_BIAS: log2 of the screen error (1 pixel at 0) a pass accepts
+*/
+static const std::vector<float> LOD_RATIOS = { 0.5f, 0.25f, 0.1f };
+static const float CAMERA_LOD_BIAS = 0.f;
+static const float SHADOW_LOD_BIAS = 1.f;
+static const float ENV_LOD_BIAS = 1.f;
+
+/* [SHADOW FACES]
+*  true: each cube face draws only what its frustum sees, with gl_Layer set in the
+*  vertex shader (GL_ARB_shader_viewport_layer_array or GL_AMD_vertex_shader_layer)
+*  false, or neither extension: the geometry shader copies every triangle to all six
+*/
+static const bool VERTEX_LAYER_SHADOWS = true;
+
+/* [SHADOW CACHING]
+*  SHADOW_EVERY_FRAME, SHADOW_ON_CHANGE (light or casters moved),
+*  SHADOW_STATIC_SPLIT (settled casters baked once, moving ones drawn over them)
+*/
+static const Geometry::ShadowCaching SHADOW_CACHING = Geometry::SHADOW_STATIC_SPLIT;
+
+/* [ENVIRONMENT PROBES]
+*  Cube maps of MODE8 objects, taken from a pool when an object enters MODE8
+*  ENV_PROBE_FORMAT: RGBA8, R11G11B10F, RGBA16F
+*  ENV_PROBE_CAPACITY: MODE8 objects beyond it reflect the static skybox
+*  ENV_FACE_BUDGET: cube faces redrawn per frame, stalest and most visible first; 0 for no limit
+*/
+static const int ENV_PROBE_SIZE = 512;
+static const EnvProbePool::Format ENV_PROBE_FORMAT = EnvProbePool::R11G11B10F;
+static const size_t ENV_PROBE_CAPACITY = 8;
+static const int ENV_FACE_BUDGET = 6;
+// one layered pass per probe (needs gl_Layer in the vertex shader) instead of one pass per face
+static const bool LAYERED_ENV_MAPS = true;
+
+/* [SCREEN SPACE REFLECTIONS]
+*  MODE9 mirrors are traced against the main pass depth and color in one
+*  full-screen pass, whatever their number; false draws them like MODE4
+*/
+static const bool SCREEN_SPACE_REFLECTIONS = true;
+
 static Skybox skybox;
 static Geometry geometry;
 static ViewControl viewcontrol;
@@ -135,14 +188,21 @@ int main(void)
 
     // Initialize the VBO with the vertices data
     // A VBO is a data container that lives in the GPU memory
+    MeshAsset::s_format = VERTEX_FORMAT;
+    Mesh::s_normal_weighting = NORMAL_WEIGHTING;
+    MeshSimplifier::s_lod_ratios = LOD_RATIOS;
+    geometry.setLodBias(Geometry::MAIN_LOD, CAMERA_LOD_BIAS);
+    geometry.setLodBias(Geometry::SHADOW_LOD, SHADOW_LOD_BIAS);
+    geometry.setLodBias(Geometry::ENV_LOD, ENV_LOD_BIAS);
+    geometry.setShadowCaching(SHADOW_CACHING);
+    geometry.configEnvProbes(ENV_PROBE_SIZE, ENV_PROBE_FORMAT, ENV_PROBE_CAPACITY);
+    geometry.setEnvFaceBudget(ENV_FACE_BUDGET);
     geometry.init();
     geometry.configShadowMap();
-    geometry.bind();
     geometry.addPlane();
 
     skybox.init();
     skybox.configCubeMap();
-    skybox.bind();
     skybox.update();
 
     // Initialize the OpenGL Program
@@ -150,6 +210,9 @@ int main(void)
     // at least a vertex shader and a fragment shader to be valid
     GLuint uniDepthMap, uniSkybox;
     std::vector<Program> programs(N_SHADER);
+    if (VERTEX_FORMAT.normals() == VertexFormat::OCTAHEDRAL_NORMALS) {
+        ProgramFactory::define("OCTAHEDRAL_NORMALS");
+    }
     programs[WIREFRAME] = ProgramFactory::createWireframeShader("outColor");
     programs[FLAT] = ProgramFactory::createFlatShader("outColor");
     programs[FLAT].bind();
@@ -167,6 +230,74 @@ int main(void)
 
     programs[SHADOW] = ProgramFactory::createShadowShader("");
 
+    // Instanced variants, used for objects that share a mesh
+    programs[WIREFRAME_INSTANCED] = ProgramFactory::createWireframeShader("outColor", true);
+    programs[FLAT_INSTANCED] = ProgramFactory::createFlatShader("outColor", true);
+    programs[FLAT_INSTANCED].bind();
+    uniDepthMap = programs[FLAT_INSTANCED].uniform("depthMap");
+    glUniform1i(uniDepthMap, 0);
+    uniSkybox = programs[FLAT_INSTANCED].uniform("skybox");
+    glUniform1i(uniSkybox, 1);
+
+    programs[PHONG_INSTANCED] = ProgramFactory::createPhongShader("outColor", true);
+    programs[PHONG_INSTANCED].bind();
+    uniDepthMap = programs[PHONG_INSTANCED].uniform("depthMap");
+    glUniform1i(uniDepthMap, 0);
+    uniSkybox = programs[PHONG_INSTANCED].uniform("skybox");
+    glUniform1i(uniSkybox, 1);
+
+    programs[SHADOW_INSTANCED] = ProgramFactory::createShadowShader("", true);
+    bool vertex_layer = VERTEX_LAYER_SHADOWS && (has_gl_extension("GL_ARB_shader_viewport_layer_array")
+        || has_gl_extension("GL_AMD_vertex_shader_layer"));
+    if (vertex_layer) {
+        programs[SHADOW_LAYERED] = ProgramFactory::createShadowShader("", true, true);
+        vertex_layer = programs[SHADOW_LAYERED].program_shader != 0;
+    }
+    geometry.setVertexLayerShadows(vertex_layer);
+    printf("[SYSTEM INFO] SHADOW CUBE FACES: %s\n", vertex_layer ? "PER-FACE DRAWS (VERTEX SHADER LAYER)" : "GEOMETRY SHADER (ALL SIX)");
+
+    // Env map variants, drawing into the cube faces picked by the instance
+    bool layered_env = LAYERED_ENV_MAPS && (has_gl_extension("GL_ARB_shader_viewport_layer_array")
+        || has_gl_extension("GL_AMD_vertex_shader_layer"));
+    if (layered_env) {
+        programs[WIREFRAME_CUBE] = ProgramFactory::createWireframeShader("outColor", false, true);
+        programs[FLAT_CUBE] = ProgramFactory::createFlatShader("outColor", false, true);
+        programs[PHONG_CUBE] = ProgramFactory::createPhongShader("outColor", false, true);
+        programs[SKYBOX_CUBE] = ProgramFactory::createSkyboxShader("outColor", true);
+        for (int mode = WIREFRAME_CUBE; mode <= SKYBOX_CUBE; ++mode) {
+            layered_env = layered_env && programs[mode].program_shader != 0;
+        }
+    }
+    if (layered_env) {
+        for (int mode = FLAT_CUBE; mode <= PHONG_CUBE; ++mode) {
+            programs[mode].bind();
+            glUniform1i(programs[mode].uniform("depthMap"), 0);
+            glUniform1i(programs[mode].uniform("skybox"), 1);
+        }
+        programs[SKYBOX_CUBE].bind();
+        glUniform1i(programs[SKYBOX_CUBE].uniform("skybox"), 0);
+    }
+    geometry.setLayeredEnvMaps(layered_env);
+    printf("[SYSTEM INFO] ENV MAP FACES: %s\n", layered_env ? "ONE LAYERED PASS PER PROBE" : "ONE PASS PER FACE");
+
+    bool ssr = SCREEN_SPACE_REFLECTIONS;
+    if (ssr) {
+        programs[SSR] = ProgramFactory::createScreenSpaceReflectionShader("outColor");
+        ssr = programs[SSR].program_shader != 0;
+    }
+    if (ssr) {
+        programs[SSR].bind();
+        glUniform1i(programs[SSR].uniform("sceneColor"), 0);
+        glUniform1i(programs[SSR].uniform("sceneDepth"), 1);
+        glUniform1i(programs[SSR].uniform("sceneReflect"), 2);
+        glUniform1i(programs[SSR].uniform("skybox"), 3);
+    }
+    geometry.setScreenSpaceReflections(ssr);
+    printf("[SYSTEM INFO] SCREEN-SPACE MIRRORS: %s\n", ssr ? "ON" : "OFF (STATIC SKYBOX)");
+
+    // Object and triangle IDs for GPU picking
+    programs[PICK] = ProgramFactory::createPickShader("outId");
+
     programs[SKYBOX] = ProgramFactory::createSkyboxShader("outColor");
     programs[SKYBOX].bind();
     uniSkybox = programs[SHADOW].uniform("skybox");
@@ -201,6 +332,8 @@ int main(void)
 
     long long int nbFrames = 0;
     long long int newFrames = 0;
+    // the per-frame counters accumulate on every rendered frame, not only the gated ones
+    long long int renderedFrames = 0;
 
     double lastTime = glfwGetTime();
     double newLastTime = glfwGetTime();
@@ -209,6 +342,10 @@ int main(void)
     const double maxPeriod = 1.0 / maxFPS;
     int counter = 0;
 
+    // programs are linked: from here on every shader name lookup should hit the cache
+    Program::resetCounters();
+    StateCache::resetCounters();
+
     glEnable(GL_DEPTH_TEST);
     // glDepthFunc(GL_GREATER);
     // Loop until the user closes the window
@@ -231,9 +368,25 @@ int main(void)
                 ++counter;
                 if (counter % 8 == 0) {
                     counter = 0;
+                    double frames = double(renderedFrames);
                     printf("\n[SYSTEM INFO] STATUS: %f ms/frame, %lld frames/s\n", 1000.0 / double(nbFrames), nbFrames);
+                    printf("[SYSTEM INFO] SUBMISSION: %.2f us/object, %.1f shader name queries/frame\n",
+                        geometry.submitTimePerObject(), double(Program::driverQueries()) / frames);
+                    printf("[SYSTEM INFO] GL STATE: %.1f binds issued/frame, %.1f suppressed/frame\n",
+                        double(StateCache::issued()) / frames, double(StateCache::suppressed()) / frames);
+                    printf("[SYSTEM INFO] MESHLETS: %.1f/%.1f drawn/tested per frame\n",
+                        double(geometry.meshletsDrawn()) / frames, double(geometry.meshletsTested()) / frames);
+                    printf("[SYSTEM INFO] SHADOWS: %.0f triangles/frame, cube updated in %.0f%% of frames (%zu static bakes)\n",
+                        double(geometry.shadowTriangles()) / frames, 100.0 * double(geometry.shadowUpdates()) / frames, geometry.shadowBakes());
+                    printf("[SYSTEM INFO] ENV MAPS: %.1f drawn/%.1f deferred/%.1f unchanged faces per frame (budget %d, max %d frames stale)\n",
+                        double(geometry.envFacesDrawn()) / frames, double(geometry.envFacesDeferred()) / frames,
+                        double(geometry.envFacesSkipped()) / frames, geometry.envFaceBudget(), geometry.envMaxStaleness());
                 }
                 nbFrames = 0;
+                renderedFrames = 0;
+                Program::resetCounters();
+                StateCache::resetCounters();
+                geometry.resetCounters();
                 lastTime += 1.0;
             }
         }
@@ -243,19 +396,18 @@ int main(void)
         // glClearDepth(0.0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        geometry.bind();
         geometry.draw(programs, viewcontrol, skybox);
 
         glDepthFunc(GL_LEQUAL);
         //glDepthMask(GL_FALSE);
-        skybox.bind();
-        skybox.draw(programs[SKYBOX], viewcontrol);
+        skybox.draw(programs[SKYBOX]);
         // glBindVertexArray(0);
         glDepthFunc(GL_LESS);
         //glDepthMask(GL_TRUE);
 
         // Swap front and back buffers
         glfwSwapBuffers(window);
+        ++renderedFrames;
 
         // Poll for and process events
         glfwPollEvents();